@@ -0,0 +1,352 @@
+#ifndef INCLUDE_ASYNC_LOG_HPP_6C2E0B7D_51A4_4F0B_9E0C_8F3D2A7B41C9
+#define INCLUDE_ASYNC_LOG_HPP_6C2E0B7D_51A4_4F0B_9E0C_8F3D2A7B41C9
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+#include "spsc-ring.hpp"
+#include "wayland-client-helper.hpp"
+
+// The lowest level compiled in: 0 trace, 1 debug, 2 info, 3 warn, 4 error, 5 off.
+#ifndef WLSYCL2_LOG_LEVEL
+#define WLSYCL2_LOG_LEVEL 1
+#endif
+
+inline namespace async_logging
+{
+
+enum class log_level : uint8_t { trace, debug, info, warn, error, off };
+
+inline constexpr log_level compiled_level = static_cast<log_level>(WLSYCL2_LOG_LEVEL);
+
+// One argument captured by value.  Strings are copied into the record, since
+// most of what Wayland hands to a listener does not outlive the callback.
+struct log_arg {
+    enum kind_t : uint8_t { boolean, character, signed_int, unsigned_int, floating, pointer, proxy, string, tuple };
+
+    kind_t kind;
+    uint16_t length;        // string: the bytes in text, tuple: the elements that follow
+    uint16_t offset;        // string: the first byte in text
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        void const* p;
+    };
+    char const* interface;  // proxy: the name of its wl_interface
+};
+
+// A fixed-size binary record; nothing is formatted on the logging thread.
+struct log_record {
+    static constexpr size_t max_args = 12;
+    static constexpr size_t max_text = 160;
+
+    int64_t time;           // steady clock [ns]
+    char const* format;     // a string literal, "{}" for each argument
+    log_level level;
+    uint8_t count;
+    uint16_t used;
+    log_arg args[max_args];
+    char text[max_text];
+
+    void push(log_arg arg) noexcept {
+        if (this->count < max_args) {
+            this->args[this->count++] = arg;
+        }
+    }
+    void push_text(std::string_view s) noexcept {
+        auto n = std::min(s.size(), max_text - this->used);
+        std::memcpy(this->text + this->used, s.data(), n);
+        log_arg arg{log_arg::string};
+        arg.offset = this->used;
+        arg.length = static_cast<uint16_t>(n);
+        this->used += n;
+        this->push(arg);
+    }
+
+    template <class T>
+    void capture(T const& value) noexcept {
+        if constexpr (std::is_same_v<T, bool>) {
+            log_arg arg{log_arg::boolean};
+            arg.u = value;
+            this->push(arg);
+        }
+        else if constexpr (std::is_same_v<T, char>) {
+            log_arg arg{log_arg::character};
+            arg.u = static_cast<unsigned char>(value);
+            this->push(arg);
+        }
+        else if constexpr (std::is_enum_v<T>) {
+            this->capture(static_cast<std::underlying_type_t<T>>(value));
+        }
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            log_arg arg{log_arg::signed_int};
+            arg.i = value;
+            this->push(arg);
+        }
+        else if constexpr (std::is_integral_v<T>) {
+            log_arg arg{log_arg::unsigned_int};
+            arg.u = value;
+            this->push(arg);
+        }
+        else if constexpr (std::is_floating_point_v<T>) {
+            log_arg arg{log_arg::floating};
+            arg.d = value;
+            this->push(arg);
+        }
+        else if constexpr (std::is_convertible_v<T, std::string_view>) {
+            if constexpr (std::is_pointer_v<T>) {
+                this->push_text(value ? std::string_view(value) : "(null)");
+            }
+            else {
+                this->push_text(value);
+            }
+        }
+        else if constexpr (std::is_pointer_v<T> && wl_client_t<std::remove_cv_t<std::remove_pointer_t<T>>>) {
+            log_arg arg{log_arg::proxy};
+            arg.p = value;
+            arg.interface = wl_interface_ref<std::remove_cv_t<std::remove_pointer_t<T>>>.name;
+            this->push(arg);
+        }
+        else if constexpr (std::is_pointer_v<T> || std::is_null_pointer_v<T>) {
+            log_arg arg{log_arg::pointer};
+            arg.p = value;
+            this->push(arg);
+        }
+        else {
+            // A tuple: a header giving the element count, then the elements.
+            log_arg arg{log_arg::tuple};
+            arg.length = std::tuple_size_v<T>;
+            this->push(arg);
+            std::apply([this](auto const&... e) { (this->capture(e), ...); }, value);
+        }
+    }
+};
+
+// Collects records from per-thread rings and writes them out on a background
+// thread.  A producer only ever touches its own ring; when the ring is full
+// the record is dropped and counted rather than waited for.
+class logger {
+    static constexpr size_t ring_size = 128;
+
+    struct log_ring {
+        spsc_ring<log_record, ring_size> records;
+        std::atomic<size_t> dropped = 0;
+    };
+
+public:
+    [[nodiscard]] static logger& instance() {
+        static logger log;
+        return log;
+    }
+    logger(logger const&) = delete;
+    logger& operator=(logger const&) = delete;
+    ~logger() noexcept {
+        this->stopping_.store(true, std::memory_order_release);
+        this->thread_.join();
+        this->drain();
+        if (auto dropped = this->dropped()) {
+            std::cerr << "log: " << dropped << " records dropped" << std::endl;
+        }
+    }
+
+    template <size_t N, class... Args>
+    void write(log_level level, char const (&format)[N], Args const&... args) noexcept {
+        log_record record;
+        record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        record.format = format;
+        record.level = level;
+        record.count = 0;
+        record.used = 0;
+        (record.capture(args), ...);
+        if (auto ring = this->local_ring(); ring && !ring->records.try_push(record)) {
+            ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    [[nodiscard]] size_t dropped() noexcept {
+        std::lock_guard lock(this->mutex_);
+        size_t n = 0;
+        for (auto& ring : this->rings_) {
+            n += ring->dropped.load(std::memory_order_relaxed);
+        }
+        return n;
+    }
+
+private:
+    logger()
+        : origin_(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::steady_clock::now().time_since_epoch()).count()),
+          thread_([this] { this->run(); })
+        {
+        }
+
+    // Registering a thread is the only allocation, once per thread.
+    log_ring* local_ring() noexcept {
+        thread_local log_ring* ring = nullptr;
+        if (!ring) {
+            try {
+                std::lock_guard lock(this->mutex_);
+                ring = this->rings_.emplace_back(std::make_unique<log_ring>()).get();
+            }
+            catch (...) {
+                return nullptr;
+            }
+        }
+        return ring;
+    }
+
+    void run() noexcept {
+        this->batch_.reserve(ring_size * 4);
+        this->line_.reserve(64 * 1024);
+        while (!this->stopping_.load(std::memory_order_acquire)) {
+            if (this->drain() == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+    }
+
+    // Formats everything queued so far, oldest first.  Returns the count.
+    size_t drain() noexcept {
+        {
+            std::lock_guard lock(this->mutex_);
+            for (auto& ring : this->rings_) {
+                while (auto record = ring->records.try_pop()) {
+                    this->batch_.push_back(*record);
+                }
+            }
+        }
+        if (this->batch_.empty()) {
+            return 0;
+        }
+        std::stable_sort(this->batch_.begin(), this->batch_.end(),
+                         [](auto const& a, auto const& b) { return a.time < b.time; });
+        this->line_.clear();
+        for (auto const& record : this->batch_) {
+            this->format(record);
+        }
+        std::cerr.write(this->line_.data(), this->line_.size());
+        std::cerr.flush();
+        auto n = this->batch_.size();
+        this->batch_.clear();
+        return n;
+    }
+
+    void format(log_record const& record) {
+        static constexpr char tags[] = "TDIWE";
+        char prefix[32];
+        std::snprintf(prefix, sizeof (prefix), "[%12.6f %c] ",
+                      (record.time - this->origin_) * 1e-9, tags[static_cast<size_t>(record.level)]);
+        this->line_ += prefix;
+        size_t next = 0;
+        for (char const* s = record.format; *s; ++s) {
+            if (s[0] == '{' && s[1] == '}') {
+                if (next < record.count) {
+                    next = this->format_arg(record, next);
+                }
+                ++s;
+            }
+            else {
+                this->line_ += *s;
+            }
+        }
+        this->line_ += '\n';
+    }
+
+    // Appends the argument at i; returns the index of the one after it.
+    size_t format_arg(log_record const& record, size_t i) {
+        auto& arg = record.args[i++];
+        char buffer[64];
+        switch (arg.kind) {
+        case log_arg::boolean:
+            this->line_ += arg.u ? "true" : "false";
+            return i;
+        case log_arg::character:
+            this->line_ += static_cast<char>(arg.u);
+            return i;
+        case log_arg::signed_int:
+            std::snprintf(buffer, sizeof (buffer), "%lld", static_cast<long long>(arg.i));
+            break;
+        case log_arg::unsigned_int:
+            std::snprintf(buffer, sizeof (buffer), "%llu", static_cast<unsigned long long>(arg.u));
+            break;
+        case log_arg::floating:
+            std::snprintf(buffer, sizeof (buffer), "%g", arg.d);
+            break;
+        case log_arg::pointer:
+            std::snprintf(buffer, sizeof (buffer), "%p", arg.p);
+            break;
+        case log_arg::proxy:
+            std::snprintf(buffer, sizeof (buffer), "%p[%s]", arg.p, arg.interface);
+            break;
+        case log_arg::string:
+            this->line_.append(record.text + arg.offset, arg.length);
+            return i;
+        case log_arg::tuple:
+            this->line_ += '(';
+            for (size_t k = 0; k < arg.length && i < record.count; ++k) {
+                this->line_ += (k == 0 ? "" : ", ");
+                i = this->format_arg(record, i);
+            }
+            this->line_ += ')';
+            return i;
+        }
+        this->line_ += buffer;
+        return i;
+    }
+
+private:
+    int64_t origin_;
+    std::mutex mutex_; // guards rings_; taken by producers only to register
+    std::vector<std::unique_ptr<log_ring>> rings_;
+    std::vector<log_record> batch_;
+    std::string line_;
+    std::atomic<bool> stopping_ = false;
+    std::thread thread_;
+};
+
+// Records below compiled_level are discarded at compile time.
+template <log_level Level, size_t N, class... Args>
+inline void log_at(char const (&format)[N], Args const&... args) noexcept {
+    if constexpr (compiled_level <= Level && Level < log_level::off) {
+        logger::instance().write(Level, format, args...);
+    }
+}
+template <size_t N, class... Args>
+inline void log_trace(char const (&format)[N], Args const&... args) noexcept {
+    log_at<log_level::trace>(format, args...);
+}
+template <size_t N, class... Args>
+inline void log_debug(char const (&format)[N], Args const&... args) noexcept {
+    log_at<log_level::debug>(format, args...);
+}
+template <size_t N, class... Args>
+inline void log_info(char const (&format)[N], Args const&... args) noexcept {
+    log_at<log_level::info>(format, args...);
+}
+template <size_t N, class... Args>
+inline void log_warn(char const (&format)[N], Args const&... args) noexcept {
+    log_at<log_level::warn>(format, args...);
+}
+template <size_t N, class... Args>
+inline void log_error(char const (&format)[N], Args const&... args) noexcept {
+    log_at<log_level::error>(format, args...);
+}
+
+} // end of namespace async_logging
+
+#endif/*INCLUDE_ASYNC_LOG_HPP_6C2E0B7D_51A4_4F0B_9E0C_8F3D2A7B41C9*/
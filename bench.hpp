@@ -0,0 +1,41 @@
+#ifndef INCLUDE_BENCH_HPP_1F2B506E_04E4_40E9_AC95_2288B370A619
+#define INCLUDE_BENCH_HPP_1F2B506E_04E4_40E9_AC95_2288B370A619
+
+#include <iostream>
+#include <chrono>
+#include <string_view>
+#include <limits>
+#include <algorithm>
+#include <memory>
+#include <cstddef>
+
+inline namespace bench
+{
+
+// Runs f() `repeat` times and reports the best wall-clock time, along with the
+// throughput of `items` units of work per run.  Returns the best time [sec].
+template <class F>
+double measure(std::string_view title, double items, F&& f, size_t repeat = 5) {
+    using clock = std::chrono::steady_clock;
+    auto best = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < repeat; ++i) {
+        auto t0 = clock::now();
+        f();
+        auto t1 = clock::now();
+        best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+    }
+    std::cout << title << ": "
+              << best * 1e3 << " ms, "
+              << items / best << " items/s" << std::endl;
+    return best;
+}
+
+// Keeps the compiler from discarding a computed value.
+template <class T>
+void do_not_optimize(T const& value) noexcept {
+    asm volatile ("" : : "r"(std::addressof(value)) : "memory");
+}
+
+} // end of namespace bench
+
+#endif/*INCLUDE_BENCH_HPP_1F2B506E_04E4_40E9_AC95_2288B370A619*/
@@ -0,0 +1,181 @@
+#ifndef INCLUDE_CONTROL_BLOCK_HPP_E3A7C5D1_92B4_4F6E_8C1A_7D05B6E2F948
+#define INCLUDE_CONTROL_BLOCK_HPP_E3A7C5D1_92B4_4F6E_8C1A_7D05B6E2F948
+
+#include <iostream>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <cstring>
+#include <cstdint>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "seqlock.hpp"
+#include "resource-accounting.hpp"
+
+inline namespace control_block_io
+{
+
+enum class backend : uint32_t {
+    any,         // the default selector
+    cpu,
+    gpu,
+    accelerator,
+};
+
+// Written by external tools, applied by the render loop at frame boundaries.
+// A zero count, scale, depth or background keeps the current setting.
+struct control_params {
+    uint32_t point_count;    // points of the spiral
+    float render_scale;      // radial scale of the spiral
+    uint32_t pipeline_depth; // chunk slots of the point cloud upload
+    backend device;          // which device the queue runs on
+    uint32_t background;     // ARGB of the cleared frame
+};
+
+// Written by the render loop after every frame.
+struct control_stats {
+    uint64_t frames;
+    uint64_t applied;        // how many parameter updates were picked up
+    float last_ms;           // host time of the last frame
+    float average_ms;
+    uint32_t rebuilt;        // the resource mask of the last frame
+    backend device;          // the backend actually in use
+};
+
+// The layout of the shared file.  Each half is a seqlock with a single writer:
+// a tool updates params by making the sequence odd, storing the words, and
+// making it even again; see seqlock.hpp.
+struct control_block {
+    static constexpr char signature[4] = {'W', 'L', 'C', 'B'};
+    static constexpr uint32_t current_version = 1;
+
+    char magic[4];
+    uint32_t version;
+    uint64_t pid;
+    alignas (64) seqlock<control_params> params;
+    alignas (64) seqlock<control_stats> stats;
+};
+
+// A mapping of a control block, either created by the renderer or opened by a
+// tool.  Polling and publishing are plain atomic loads and stores on the
+// mapping; no locks or system calls.
+class control_channel {
+public:
+    control_channel(control_block* block, std::string path, bool owner) noexcept
+        : block_(block), path_(std::move(path)), owner_(owner),
+          seen_(block->params.version())
+        {
+            track_acquire(account::mapped_files, sizeof (control_block));
+        }
+    control_channel(control_channel const&) = delete;
+    control_channel& operator=(control_channel const&) = delete;
+    ~control_channel() noexcept {
+        munmap(this->block_, sizeof (control_block));
+        track_release(account::mapped_files, sizeof (control_block));
+        if (this->owner_) {
+            unlink(this->path_.c_str());
+        }
+    }
+
+    // Renderer side: the parameters, when they changed since the last call.
+    [[nodiscard]] std::optional<control_params> poll() noexcept {
+        auto version = this->block_->params.version();
+        if (version == this->seen_) {
+            return std::nullopt;
+        }
+        auto params = this->block_->params.load();
+        this->seen_ = version;
+        return params;
+    }
+    void publish(control_stats const& stats) noexcept {
+        this->block_->stats.store(stats);
+    }
+
+    // Tool side.
+    [[nodiscard]] control_params params() const noexcept {
+        return this->block_->params.load();
+    }
+    void update(control_params const& params) noexcept {
+        this->block_->params.store(params);
+    }
+    [[nodiscard]] control_stats stats() const noexcept {
+        return this->block_->stats.load();
+    }
+
+private:
+    control_block* block_;
+    std::string path_;
+    bool owner_;
+    uint64_t seen_;
+};
+
+// Creates the control block at `path` for the renderer, holding `initial`.
+[[nodiscard]] inline auto create_control_block(std::string_view path,
+                                               control_params const& initial) noexcept
+{
+    std::unique_ptr<control_channel> nil;
+    int fd = open(std::string(path).c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        std::cerr << "Failed to open the control block..." << std::endl;
+        return nil;
+    }
+    if (ftruncate(fd, sizeof (control_block)) < 0) {
+        std::cerr << "Failed to ftruncate the control block..." << std::endl;
+        close(fd);
+        return nil;
+    }
+    auto data = mmap(nullptr, sizeof (control_block), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "Failed to mmap the control block..." << std::endl;
+        return nil;
+    }
+    auto block = new (data) control_block{};
+    std::memcpy(block->magic, block->signature, sizeof (block->magic));
+    block->version = block->current_version;
+    block->pid = getpid();
+    block->params.store(initial);
+    return std::make_unique<control_channel>(block, std::string(path), true);
+}
+
+// Opens an existing control block for a tool.
+[[nodiscard]] inline auto open_control_block(std::string_view path) noexcept {
+    std::unique_ptr<control_channel> nil;
+    int fd = open(std::string(path).c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Failed to open the control block..." << std::endl;
+        return nil;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof (control_block)) {
+        std::cerr << "The control block is too short..." << std::endl;
+        close(fd);
+        return nil;
+    }
+    auto data = mmap(nullptr, sizeof (control_block), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "Failed to mmap the control block..." << std::endl;
+        return nil;
+    }
+    auto block = static_cast<control_block*>(data);
+    if (std::memcmp(block->magic, block->signature, sizeof (block->magic)) ||
+        block->version != block->current_version)
+    {
+        std::cerr << "Not a control block..." << std::endl;
+        munmap(data, sizeof (control_block));
+        return nil;
+    }
+    return std::make_unique<control_channel>(block, std::string(path), false);
+}
+
+} // end of namespace control_block_io
+
+#endif/*INCLUDE_CONTROL_BLOCK_HPP_E3A7C5D1_92B4_4F6E_8C1A_7D05B6E2F948*/
@@ -13,6 +13,11 @@
 
 #include <utility>
 #include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <atomic>
+#include <cstddef>
 #include <cassert>
 
 namespace std::inline experimental
@@ -203,29 +208,185 @@ struct suspend_always {
     void await_resume() const noexcept { }
 };
 
-template <class T>
+// A fixed-size free-list pool for coroutine frames.  Frames up to BlockSize
+// bytes, header included, are carved out of a per-thread arena of BlockCount
+// blocks; larger frames, or any request made while the arena is exhausted,
+// fall back to the global operator new.  The header records the arena a frame
+// came from: a frame released on another thread goes back to its arena through
+// a lock-free list, and an arena whose thread exits while some of its frames
+// are still alive is destroyed by the last of them instead.
+template <size_t BlockSize = 512, size_t BlockCount = 64>
+struct frame_pool {
+    using value_type = std::byte;
+
+    [[nodiscard]] std::byte* allocate(size_t size) {
+        auto& arena = frame_pool::arena();
+        if (size + header_size <= BlockSize && (arena.head || arena.reclaim())) {
+            auto block = std::exchange(arena.head, arena.head->next);
+            ++arena.used;
+            return frame_pool::attach(block->storage, &arena);
+        }
+        return frame_pool::attach(static_cast<std::byte*>(::operator new(size + header_size)), nullptr);
+    }
+    void deallocate(std::byte* ptr, size_t size) noexcept {
+        auto base = ptr - header_size;
+        auto owner = reinterpret_cast<header*>(base)->owner;
+        if (!owner) {
+            ::operator delete(base, size + header_size);
+        }
+        else if (owner == local_arena) {
+            auto block = reinterpret_cast<typename arena_type::block*>(base);
+            block->next = std::exchange(owner->head, block);
+            --owner->used;
+        }
+        else {
+            owner->give_back(reinterpret_cast<typename arena_type::block*>(base));
+        }
+    }
+
+private:
+    struct arena_type;
+    struct header {
+        arena_type* owner; // null for frames from operator new
+    };
+    static constexpr size_t header_size = alignof (std::max_align_t);
+    static_assert(sizeof (header) <= header_size);
+
+    struct arena_type {
+        union block {
+            block* next;
+            alignas (std::max_align_t) std::byte storage[BlockSize];
+        };
+        block blocks[BlockCount];
+        block* head = nullptr;
+        size_t used = 0;                        // blocks not on the free list
+        std::atomic<block*> returned = nullptr; // released on other threads
+        std::atomic<ptrdiff_t> orphans = 0;     // blocks alive after the thread
+
+        // Marks `returned` once the owner thread has exited.
+        static block* exited() noexcept {
+            static block marker;
+            return &marker;
+        }
+
+        arena_type() noexcept {
+            for (auto& b : this->blocks) {
+                b.next = std::exchange(this->head, &b);
+            }
+        }
+
+        // Owner thread: moves the blocks released elsewhere to the free list.
+        bool reclaim() noexcept {
+            auto b = this->returned.exchange(nullptr, std::memory_order_acquire);
+            while (b) {
+                auto next = b->next;
+                b->next = std::exchange(this->head, b);
+                --this->used;
+                b = next;
+            }
+            return this->head;
+        }
+        // Any other thread.
+        void give_back(block* b) noexcept {
+            b->next = this->returned.load(std::memory_order_relaxed);
+            do {
+                if (b->next == exited()) {
+                    if (this->orphans.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        delete this;
+                    }
+                    return ;
+                }
+            } while (!this->returned.compare_exchange_weak(b->next, b,
+                                                           std::memory_order_release,
+                                                           std::memory_order_relaxed));
+        }
+        // Owner thread, on exit.  Whoever brings the orphans to zero, this or
+        // the last give_back, destroys the arena.
+        void abandon() noexcept {
+            auto b = this->returned.exchange(exited(), std::memory_order_acquire);
+            for (; b; b = b->next) {
+                --this->used;
+            }
+            auto n = static_cast<ptrdiff_t>(this->used);
+            if (this->orphans.fetch_add(n, std::memory_order_acq_rel) + n == 0) {
+                delete this;
+            }
+        }
+    };
+
+    struct arena_owner {
+        arena_type* arena = new arena_type;
+
+        ~arena_owner() noexcept {
+            local_arena = nullptr;
+            this->arena->abandon();
+        }
+    };
+
+    static std::byte* attach(std::byte* base, arena_type* owner) noexcept {
+        reinterpret_cast<header*>(base)->owner = owner;
+        return base + header_size;
+    }
+    static arena_type& arena() {
+        thread_local arena_owner instance;
+        local_arena = instance.arena;
+        return *instance.arena;
+    }
+
+    static inline thread_local arena_type* local_arena = nullptr;
+};
+
+template <class T, class Allocator = frame_pool<>>
 struct generator {
+    using value_type = std::remove_cvref_t<T>;
+
     struct promise_type {
-        T value_;
+        // Points at the yielded object itself, which stays alive for as long as
+        // the coroutine is suspended in the co_yield expression.  A yielded
+        // lvalue may be a local of the coroutine, so the iterator only hands
+        // out const access to it.
+        value_type* value_ = nullptr;
+
+        static void* operator new(size_t size) {
+            return Allocator().allocate(size);
+        }
+        static void operator delete(void* ptr, size_t size) noexcept {
+            Allocator().deallocate(static_cast<std::byte*>(ptr), size);
+        }
 
         generator get_return_object() noexcept { return generator{*this}; }
         std::suspend_always initial_suspend() noexcept { return {}; }
         std::suspend_always final_suspend()   noexcept { return {}; }
         void unhandled_exception() { throw; }
-        std::suspend_always yield_value(T const& value) noexcept {
-            this->value_ = value;
+        std::suspend_always yield_value(value_type& value) noexcept {
+            this->value_ = std::addressof(value);
+            return {};
+        }
+        std::suspend_always yield_value(value_type&& value) noexcept {
+            this->value_ = std::addressof(value);
             return {};
         }
+        auto yield_value(value_type const& value) {
+            // Only a const lvalue has to be copied, into the awaiter which
+            // lives in the frame across the suspension.
+            struct awaiter : std::suspend_always {
+                value_type copy;
+                void await_suspend(coroutine_handle<promise_type> coro) noexcept {
+                    coro.promise().value_ = std::addressof(this->copy);
+                }
+            };
+            return awaiter{{}, value};
+        }
         void return_void() noexcept { }
     };
     struct iterator {
         using iterator_category = std::input_iterator_tag;
         using size_type         = std::size_t;
         using differnce_type    = std::ptrdiff_t;
-        using value_type        = std::remove_cvref_t<T>;
-        using reference         = value_type&;
+        using value_type        = generator::value_type;
+        using reference         = value_type const&;
         using const_reference   = value_type const&;
-        using pointer           = value_type*;
+        using pointer           = value_type const*;
         using const_pointer     = value_type const*;
 
         coroutine_handle<promise_type> coro_ = nullptr;
@@ -241,10 +402,8 @@ struct generator {
             }
             return *this;
         }
-        iterator& operator++(int) {
-            auto tmp = *this;
+        void operator++(int) {
             ++*this;
-            return tmp;
         }
         [[nodiscard]]
         friend bool operator==(iterator const& lhs, std::default_sentinel_t) noexcept {
@@ -254,18 +413,12 @@ struct generator {
         friend bool operator!=(std::default_sentinel_t, iterator const& rhs) noexcept {
             return rhs.coro_.done();
         }
-        [[nodiscard]] const_reference operator*() const noexcept {
-            return this->coro_.promise().value_;
+        [[nodiscard]] reference operator*() const noexcept {
+            return *this->coro_.promise().value_;
         }
-        [[nodiscard]] reference operator*() noexcept {
+        [[nodiscard]] pointer operator->() const noexcept {
             return this->coro_.promise().value_;
         }
-        [[nodiscard]] const_pointer operator->() const noexcept {
-            return std::addressof(this->coro_.promise().value_);
-        }
-        [[nodiscard]] pointer operator->() noexcept {
-            return std::addressof(this->coro_.promise().value_);
-        }
     };
     [[nodiscard]] iterator begin() {
         if (this->coro_) {
@@ -297,8 +450,11 @@ struct generator {
         }
     }
     generator& operator=(generator const&) = delete;
-    generator& operator=(generator&& rhs) {
+    generator& operator=(generator&& rhs) noexcept {
         if (this != &rhs) {
+            if (this->coro_) {
+                this->coro_.destroy();
+            }
             this->coro_ = std::exchange(rhs.coro_, nullptr);
         }
         return *this;
@@ -0,0 +1,267 @@
+#ifndef INCLUDE_DENSITY_HPP_0A5EA11B_B7BB_4C30_865E_E286A9593A07
+#define INCLUDE_DENSITY_HPP_0A5EA11B_B7BB_4C30_865E_E286A9593A07
+
+#include <algorithm>
+#include <complex>
+#include <limits>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include <utility>
+#include <cmath>
+#include <cstdint>
+
+#include <CL/sycl.hpp>
+
+#include "versor.hpp"
+#include "frame-view.hpp"
+#include "resource-accounting.hpp"
+
+inline namespace density_accumulation
+{
+
+enum class scatter_mode {
+    last_writer,   // plot straight into the framebuffer
+    global_atomic, // count hits with one global atomic per point
+    privatized,    // count hits in work-group-private histograms
+};
+
+// Counts hits per pixel into the density buffer.
+//
+// The privatized mode bins the points by screen tile first, so that each tile
+// can then be accumulated by a single work-group in local memory:
+//   1. bin:        per-group tile histograms, merged into global tile counts
+//   2. scan:       tile counts to tile offsets
+//   3. place:      per-group tile histograms again, one global atomic per
+//                  tile reserving a range, then local offsets within it
+//   4. accumulate: one group per tile, local bins, plain stores
+// Every global atomic is taken once per tile and work-group, not per point.
+class density_accumulator {
+    static constexpr size_t tile = 64;   // tile edge [px]; tile*tile bins fit local memory
+    static constexpr size_t group = 256;
+    static constexpr uint32_t offscreen = frame_view::offscreen;
+
+    template <sycl::access::address_space Space>
+    using counter = sycl::atomic_ref<uint32_t,
+                                     sycl::memory_order::relaxed,
+                                     Space == sycl::access::address_space::local_space
+                                     ? sycl::memory_scope::work_group
+                                     : sycl::memory_scope::device,
+                                     Space>;
+    using local_counter  = counter<sycl::access::address_space::local_space>;
+    using global_counter = counter<sycl::access::address_space::global_space>;
+
+public:
+    explicit density_accumulator(sycl::queue& queue) noexcept
+        : queue_(queue)
+        {
+        }
+    density_accumulator(density_accumulator const&) = delete;
+    density_accumulator& operator=(density_accumulator const&) = delete;
+    ~density_accumulator() noexcept {
+        this->release();
+    }
+
+    // position(i) gives the frame coordinates of the i-th of `count` points.
+    template <class Position>
+    node_events accumulate(scatter_mode mode, frame_view const& view,
+                           size_t count, Position position,
+                           std::vector<sycl::event> const& deps)
+    {
+        if (mode == scatter_mode::global_atomic) {
+            auto e = this->queue_.parallel_for(sycl::range<1>{count}, deps, [=](sycl::id<1> i) {
+                if (auto key = pixel_of(view, position(i)); key != offscreen) {
+                    global_counter(view.density[key]).fetch_add(1);
+                }
+            });
+            return {e, e};
+        }
+        size_t tiles_x = (view.cx + tile - 1) / tile;
+        size_t tiles = tiles_x * ((view.cy + tile - 1) / tile);
+        this->reserve(count, tiles);
+        auto keys    = this->keys_;
+        auto sorted  = this->sorted_;
+        auto counts  = this->counts_;
+        auto offsets = this->offsets_;
+        auto points = sycl::nd_range<1>{(count + group - 1) / group * group, group};
+        auto tile_of = [=](uint32_t key) {
+            return (key / view.cx / tile) * tiles_x + (key % view.cx) / tile;
+        };
+
+        auto cleared = this->queue_.memset(counts, 0, tiles * sizeof (uint32_t), deps);
+        auto binned = this->queue_.submit([&](sycl::handler& h) {
+            h.depends_on(cleared);
+            auto hist = sycl::local_accessor<uint32_t, 1>(sycl::range<1>{tiles}, h);
+            h.parallel_for(points, [=](sycl::nd_item<1> it) {
+                auto lid = it.get_local_id(0);
+                for (size_t t = lid; t < tiles; t += group) {
+                    hist[t] = 0;
+                }
+                sycl::group_barrier(it.get_group());
+                auto i = it.get_global_id(0);
+                if (i < count) {
+                    auto key = pixel_of(view, position(i));
+                    keys[i] = key;
+                    if (key != offscreen) {
+                        local_counter(hist[tile_of(key)]).fetch_add(1);
+                    }
+                }
+                sycl::group_barrier(it.get_group());
+                for (size_t t = lid; t < tiles; t += group) {
+                    if (hist[t]) {
+                        global_counter(counts[t]).fetch_add(hist[t]);
+                    }
+                }
+            });
+        });
+        // The tile counts become the cursors of the place step.
+        auto scanned = this->queue_.single_task(binned, [=] {
+            uint32_t sum = 0;
+            for (size_t t = 0; t < tiles; ++t) {
+                offsets[t] = sum;
+                sum += std::exchange(counts[t], sum);
+            }
+            offsets[tiles] = sum;
+        });
+        auto placed = this->queue_.submit([&](sycl::handler& h) {
+            h.depends_on(scanned);
+            auto hist = sycl::local_accessor<uint32_t, 1>(sycl::range<1>{tiles}, h);
+            h.parallel_for(points, [=](sycl::nd_item<1> it) {
+                auto lid = it.get_local_id(0);
+                for (size_t t = lid; t < tiles; t += group) {
+                    hist[t] = 0;
+                }
+                sycl::group_barrier(it.get_group());
+                auto i = it.get_global_id(0);
+                auto key = i < count ? keys[i] : offscreen;
+                uint32_t local_offset = 0;
+                if (key != offscreen) {
+                    local_offset = local_counter(hist[tile_of(key)]).fetch_add(1);
+                }
+                sycl::group_barrier(it.get_group());
+                for (size_t t = lid; t < tiles; t += group) {
+                    if (hist[t]) {
+                        hist[t] = global_counter(counts[t]).fetch_add(hist[t]);
+                    }
+                }
+                sycl::group_barrier(it.get_group());
+                if (key != offscreen) {
+                    sorted[hist[tile_of(key)] + local_offset] = key;
+                }
+            });
+        });
+        auto accumulated = this->queue_.submit([&](sycl::handler& h) {
+            h.depends_on(placed);
+            auto bins = sycl::local_accessor<uint32_t, 1>(sycl::range<1>{tile * tile}, h);
+            h.parallel_for(sycl::nd_range<1>{tiles * group, group}, [=](sycl::nd_item<1> it) {
+                auto t = it.get_group(0);
+                auto lid = it.get_local_id(0);
+                for (size_t b = lid; b < tile * tile; b += group) {
+                    bins[b] = 0;
+                }
+                sycl::group_barrier(it.get_group());
+                for (size_t j = offsets[t] + lid; j < offsets[t+1]; j += group) {
+                    auto key = sorted[j];
+                    local_counter(bins[(key / view.cx % tile) * tile + key % view.cx % tile]).fetch_add(1);
+                }
+                sycl::group_barrier(it.get_group());
+                auto x0 = t % tiles_x * tile;
+                auto y0 = t / tiles_x * tile;
+                for (size_t b = lid; b < tile * tile; b += group) {
+                    auto x = x0 + b % tile;
+                    auto y = y0 + b / tile;
+                    if (x < view.cx && y < view.cy && bins[b]) {
+                        // The tile is owned by this work-group alone.
+                        view.density[y * view.cx + x] += bins[b];
+                    }
+                }
+            });
+        });
+        return {cleared, accumulated};
+    }
+
+private:
+    static uint32_t pixel_of(frame_view const& view, std::complex<float> c) noexcept {
+        return view.index_of(c.real(), c.imag());
+    }
+
+    void reserve(size_t count, size_t tiles) {
+        if (this->capacity_ < count || this->tiles_ < tiles) {
+            this->release();
+            this->capacity_ = std::max(count, this->capacity_);
+            this->tiles_ = std::max(tiles, this->tiles_);
+            this->keys_    = sycl::malloc_device<uint32_t>(this->capacity_, this->queue_);
+            this->sorted_  = sycl::malloc_device<uint32_t>(this->capacity_, this->queue_);
+            this->counts_  = sycl::malloc_device<uint32_t>(this->tiles_, this->queue_);
+            this->offsets_ = sycl::malloc_device<uint32_t>(this->tiles_ + 1, this->queue_);
+            track_acquire(account::device, this->bytes(), 4);
+        }
+    }
+    void release() noexcept {
+        this->queue_.wait();
+        if (this->keys_) {
+            track_release(account::device, this->bytes(), 4);
+        }
+        for (auto p : {this->keys_, this->sorted_, this->counts_, this->offsets_}) {
+            if (p) {
+                sycl::free(p, this->queue_);
+            }
+        }
+        this->keys_ = this->sorted_ = this->counts_ = this->offsets_ = nullptr;
+    }
+
+    size_t bytes() const noexcept {
+        return (2 * this->capacity_ + 2 * this->tiles_ + 1) * sizeof (uint32_t);
+    }
+
+private:
+    sycl::queue& queue_;
+    size_t capacity_ = 0;
+    size_t tiles_ = 0;
+    uint32_t* keys_ = nullptr;
+    uint32_t* sorted_ = nullptr;
+    uint32_t* counts_ = nullptr;
+    uint32_t* offsets_ = nullptr;
+};
+
+struct density_clear_stage {
+    static constexpr std::string_view name = "clear density";
+    static constexpr bool elementwise = true;
+    static constexpr uint32_t reads  = 0;
+    static constexpr uint32_t writes = resource::density;
+
+    bool active;
+
+    bool enabled() const noexcept { return this->active; }
+    auto key() const noexcept { return this->active; }
+    void operator()(frame_view const& view, size_t i) const noexcept {
+        view.density[i] = 0;
+    }
+};
+
+// Maps hit counts to a heat colour: black, red, yellow, white.
+struct tonemap_stage {
+    static constexpr std::string_view name = "tonemap";
+    static constexpr bool elementwise = true;
+    static constexpr uint32_t reads  = resource::density;
+    static constexpr uint32_t writes = resource::framebuffer;
+
+    bool active;
+    float exposure; // the density giving roughly 63% brightness is 1/exposure
+
+    bool enabled() const noexcept { return this->active; }
+    auto key() const noexcept { return std::tuple(this->active, this->exposure); }
+    void operator()(frame_view const& view, size_t i) const noexcept {
+        if (view.density[i]) {
+            float v = 1.0f - std::exp(-this->exposure * view.density[i]);
+            auto ramp = [v](float lo) {
+                return static_cast<uint8_t>(std::clamp(3.0f * v - lo, 0.0f, 1.0f) * 0xFF);
+            };
+            view.pixels[i] = color(0xC0, ramp(0), ramp(1), ramp(2));
+        }
+    }
+};
+
+} // end of namespace density_accumulation
+
+#endif/*INCLUDE_DENSITY_HPP_0A5EA11B_B7BB_4C30_865E_E286A9593A07*/
@@ -0,0 +1,275 @@
+#ifndef INCLUDE_FRAME_CAPTURE_HPP_0AF81F2F_7C55_48F7_80BA_B54711DF0844
+#define INCLUDE_FRAME_CAPTURE_HPP_0AF81F2F_7C55_48F7_80BA_B54711DF0844
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <exception>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "spsc-ring.hpp"
+#include "versor.hpp"
+#include "resource-accounting.hpp"
+
+inline namespace frame_capture_io
+{
+
+enum class capture_format {
+    raw, // Concatenated ARGB8888 frames, exactly as in the shm buffer.
+    y4m, // YUV4MPEG2, 4:4:4 BT.601.
+};
+
+struct damage_rect {
+    size_t x, y, cx, cy;
+
+    [[nodiscard]] bool empty() const noexcept { return this->cx == 0 || this->cy == 0; }
+
+    // The bounding box of both rectangles.
+    friend damage_rect operator | (damage_rect lhs, damage_rect rhs) noexcept {
+        if (lhs.empty()) return rhs;
+        if (rhs.empty()) return lhs;
+        auto x0 = std::min(lhs.x, rhs.x);
+        auto y0 = std::min(lhs.y, rhs.y);
+        auto x1 = std::max(lhs.x + lhs.cx, rhs.x + rhs.cx);
+        auto y1 = std::max(lhs.y + lhs.cy, rhs.y + rhs.cy);
+        return {x0, y0, x1 - x0, y1 - y0};
+    }
+};
+
+// Records committed frames into a memory-mapped file without blocking the
+// render loop.  snapshot() copies the damaged region into one of a fixed set
+// of reusable slots and hands it to a writer thread, which patches it over the
+// previous frame in the file.  When every slot is still in flight the frame is
+// dropped (its damage is carried over to the next snapshot) instead of waiting.
+class frame_capture {
+    static constexpr size_t slot_count = 4;
+
+    struct slot {
+        damage_rect damage;
+        std::vector<color> pixels; // packed rows of the damaged region
+    };
+
+public:
+    // Takes over fd and the mapping only once constructed; may throw.
+    frame_capture(int fd, void* data, size_t cx, size_t cy,
+                  capture_format format, size_t max_frames)
+        : fd_(fd), data_(static_cast<uint8_t*>(data)),
+          cx_(cx), cy_(cy), format_(format), max_frames_(max_frames),
+          header_(header(cx, cy, format))
+        {
+            for (size_t i = 0; i < slot_count; ++i) {
+                this->slots_[i].pixels.resize(cx * cy);
+                [[maybe_unused]] bool ok = this->free_.try_push(i);
+            }
+            std::memcpy(this->data_, this->header_.data(), this->header_.size());
+            this->writer_ = std::thread([this] { this->write_frames(); });
+            track_acquire(account::host_staging, slot_count * cx * cy * sizeof (color), slot_count);
+            track_acquire(account::mapped_files, this->file_bytes());
+        }
+    frame_capture(frame_capture const&) = delete;
+    frame_capture& operator=(frame_capture const&) = delete;
+    ~frame_capture() noexcept {
+        this->stopping_.store(true, std::memory_order_release);
+        this->signal_.fetch_add(1, std::memory_order_release);
+        this->signal_.notify_one();
+        this->writer_.join();
+        auto size = this->header_.size() + this->frame_bytes() * this->written();
+        munmap(this->data_, this->file_bytes());
+        track_release(account::mapped_files, this->file_bytes());
+        track_release(account::host_staging, slot_count * this->cx_ * this->cy_ * sizeof (color), slot_count);
+        if (ftruncate(this->fd_, size) < 0) {
+            std::cerr << "Failed to ftruncate the capture file..." << std::endl;
+        }
+        close(this->fd_);
+    }
+
+    // Called from the render loop once per committed frame.  Never blocks.
+    bool snapshot(color const* pixels, damage_rect damage) noexcept {
+        damage = this->clip(damage | this->carried_);
+        auto index = this->free_.try_pop();
+        if (!index) {
+            this->carried_ = damage;
+            this->dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        this->carried_ = {};
+        auto& s = this->slots_[*index];
+        s.damage = damage;
+        for (size_t y = 0; y < damage.cy; ++y) {
+            std::memcpy(s.pixels.data() + y * damage.cx,
+                        pixels + (damage.y + y) * this->cx_ + damage.x,
+                        damage.cx * sizeof (color));
+        }
+        [[maybe_unused]] bool ok = this->filled_.try_push(*index);
+        this->signal_.fetch_add(1, std::memory_order_release);
+        this->signal_.notify_one();
+        return true;
+    }
+
+    [[nodiscard]] size_t written() const noexcept {
+        return this->written_.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] size_t dropped() const noexcept {
+        return this->dropped_.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] static size_t file_bytes(size_t cx, size_t cy,
+                                           capture_format format,
+                                           size_t max_frames) noexcept
+    {
+        return header(cx, cy, format).size() + frame_bytes(cx, cy, format) * max_frames;
+    }
+
+private:
+    static std::string header(size_t cx, size_t cy, capture_format format) {
+        if (format == capture_format::y4m) {
+            return "YUV4MPEG2 W" + std::to_string(cx) + " H" + std::to_string(cy)
+                 + " F60:1 Ip A1:1 C444\n";
+        }
+        return {};
+    }
+    static size_t frame_bytes(size_t cx, size_t cy, capture_format format) noexcept {
+        if (format == capture_format::y4m) {
+            return frame_tag.size() + 3 * cx * cy;
+        }
+        return sizeof (color) * cx * cy;
+    }
+    size_t frame_bytes() const noexcept { return frame_bytes(this->cx_, this->cy_, this->format_); }
+    size_t file_bytes() const noexcept {
+        return file_bytes(this->cx_, this->cy_, this->format_, this->max_frames_);
+    }
+
+    damage_rect clip(damage_rect r) const noexcept {
+        auto x1 = std::min(r.x + r.cx, this->cx_);
+        auto y1 = std::min(r.y + r.cy, this->cy_);
+        r.x = std::min(r.x, x1);
+        r.y = std::min(r.y, y1);
+        return {r.x, r.y, x1 - r.x, y1 - r.y};
+    }
+
+    void write_frames() noexcept {
+        for (;;) {
+            auto observed = this->signal_.load(std::memory_order_acquire);
+            if (auto index = this->filled_.try_pop()) {
+                this->write_frame(this->slots_[*index]);
+                [[maybe_unused]] bool ok = this->free_.try_push(*index);
+            }
+            else if (this->stopping_.load(std::memory_order_acquire)) {
+                return;
+            }
+            else {
+                this->signal_.wait(observed, std::memory_order_acquire);
+            }
+        }
+    }
+
+    void write_frame(slot const& s) noexcept {
+        auto n = this->written_.load(std::memory_order_relaxed);
+        if (n == this->max_frames_) {
+            this->dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        auto frame = this->data_ + this->header_.size() + this->frame_bytes() * n;
+        // Start from the previous frame, then patch in the damaged region.
+        if (n != 0) {
+            std::memcpy(frame, frame - this->frame_bytes(), this->frame_bytes());
+        }
+        if (this->format_ == capture_format::y4m) {
+            std::memcpy(frame, frame_tag.data(), frame_tag.size());
+            auto plane = this->cx_ * this->cy_;
+            auto yp = frame + frame_tag.size();
+            auto up = yp + plane;
+            auto vp = up + plane;
+            for (size_t y = 0; y < s.damage.cy; ++y) {
+                for (size_t x = 0; x < s.damage.cx; ++x) {
+                    // Bytes of an ARGB8888 pixel in memory: B, G, R, A.
+                    auto p = reinterpret_cast<uint8_t const*>(&s.pixels[y * s.damage.cx + x]);
+                    int b = p[0], g = p[1], r = p[2];
+                    auto i = (s.damage.y + y) * this->cx_ + s.damage.x + x;
+                    yp[i] = ((  66*r + 129*g +  25*b + 128) >> 8) +  16;
+                    up[i] = (( -38*r -  74*g + 112*b + 128) >> 8) + 128;
+                    vp[i] = (( 112*r -  94*g -  18*b + 128) >> 8) + 128;
+                }
+            }
+        }
+        else {
+            auto pixels = reinterpret_cast<color*>(frame);
+            for (size_t y = 0; y < s.damage.cy; ++y) {
+                std::memcpy(pixels + (s.damage.y + y) * this->cx_ + s.damage.x,
+                            s.pixels.data() + y * s.damage.cx,
+                            s.damage.cx * sizeof (color));
+            }
+        }
+        this->written_.store(n + 1, std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr std::string_view frame_tag = "FRAME\n";
+
+    int fd_;
+    uint8_t* data_;
+    size_t cx_;
+    size_t cy_;
+    capture_format format_;
+    size_t max_frames_;
+    std::string header_;
+    damage_rect carried_ = {};
+    slot slots_[slot_count];
+    spsc_ring<size_t, slot_count> free_;   // writer -> render loop
+    spsc_ring<size_t, slot_count> filled_; // render loop -> writer
+    std::atomic<uint32_t> signal_ = 0;
+    std::atomic<bool> stopping_ = false;
+    std::atomic<size_t> written_ = 0;
+    std::atomic<size_t> dropped_ = 0;
+    std::thread writer_;
+};
+
+// Opens `path` for capturing up to `max_frames` frames of cx x cy pixels.  The
+// format is chosen by the file extension (".y4m", or raw otherwise).
+[[nodiscard]] inline auto create_frame_capture(std::string_view path,
+                                               size_t cx, size_t cy,
+                                               size_t max_frames) noexcept
+{
+    std::unique_ptr<frame_capture> nil;
+    auto format = path.ends_with(".y4m") ? capture_format::y4m : capture_format::raw;
+    auto size = frame_capture::file_bytes(cx, cy, format, max_frames);
+    int fd = open(std::string(path).c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to open the capture file..." << std::endl;
+        return nil;
+    }
+    if (ftruncate(fd, size) < 0) {
+        std::cerr << "Failed to ftruncate the capture file..." << std::endl;
+        close(fd);
+        return nil;
+    }
+    auto data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        std::cerr << "Failed to mmap the capture file..." << std::endl;
+        close(fd);
+        return nil;
+    }
+    try {
+        return std::make_unique<frame_capture>(fd, data, cx, cy, format, max_frames);
+    }
+    catch (std::exception& ex) {
+        std::cerr << "Failed to start the frame capture: " << ex.what() << std::endl;
+        munmap(data, size);
+        close(fd);
+        return nil;
+    }
+}
+
+} // end of namespace frame_capture_io
+
+#endif/*INCLUDE_FRAME_CAPTURE_HPP_0AF81F2F_7C55_48F7_80BA_B54711DF0844*/
@@ -0,0 +1,102 @@
+#ifndef INCLUDE_FRAME_VIEW_HPP_2C7939E4_6F62_4421_8E41_54200F4E7E3F
+#define INCLUDE_FRAME_VIEW_HPP_2C7939E4_6F62_4421_8E41_54200F4E7E3F
+
+#include <limits>
+#include <cmath>
+#include <cstdint>
+
+#include <CL/sycl.hpp>
+
+#include "versor.hpp"
+#include "resource-accounting.hpp"
+
+inline namespace frame_views
+{
+
+// Resources read and written by the stages, as bits of a mask.
+enum resource : uint32_t {
+    framebuffer = 1u << 0, // device-side pixels
+    presented   = 1u << 1, // the shm buffer handed to the compositor
+    bloom       = 1u << 2, // the blurred framebuffer
+    density     = 1u << 3, // hit counts per pixel
+};
+
+// The commands a stage submitted for one frame.
+struct node_events {
+    sycl::event first;
+    sycl::event last;
+};
+
+// The device-side frame, passed by value into kernels.
+struct frame_view {
+    static constexpr uint32_t offscreen = std::numeric_limits<uint32_t>::max();
+
+    color* pixels;
+    color* bloom;
+    color* scratch; // intermediate of separable filters
+    uint32_t* density;
+    size_t cx;
+    size_t cy;
+
+    size_t size() const noexcept { return this->cx * this->cy; }
+
+    // The pixel nearest to (x, y), or offscreen.
+    uint32_t index_of(float x, float y) const noexcept {
+        auto rx = std::round(x);
+        auto ry = std::round(y);
+        if (0.0f <= rx && rx < this->cx && 0.0f <= ry && ry < this->cy) {
+            return static_cast<uint32_t>(ry) * this->cx + static_cast<uint32_t>(rx);
+        }
+        return offscreen;
+    }
+
+    // Writes a single point, discarding it when it falls outside of the frame.
+    void plot(float x, float y, color c) const noexcept {
+        if (auto i = this->index_of(x, y); i != offscreen) {
+            this->pixels[i] = c;
+        }
+    }
+};
+
+// Owns the device allocations behind a frame_view.
+class frame_resources {
+public:
+    frame_resources(sycl::queue& queue, size_t cx, size_t cy)
+        : queue_(queue),
+          view_{
+              .pixels  = sycl::malloc_device<color>(cx * cy, queue),
+              .bloom   = sycl::malloc_device<color>(cx * cy, queue),
+              .scratch = sycl::malloc_device<color>(cx * cy, queue),
+              .density = sycl::malloc_device<uint32_t>(cx * cy, queue),
+              .cx = cx,
+              .cy = cy,
+          }
+        {
+            track_acquire(account::device, this->bytes(), 4);
+        }
+    frame_resources(frame_resources const&) = delete;
+    frame_resources& operator=(frame_resources const&) = delete;
+    ~frame_resources() noexcept {
+        this->queue_.wait();
+        sycl::free(this->view_.pixels, this->queue_);
+        sycl::free(this->view_.bloom, this->queue_);
+        sycl::free(this->view_.scratch, this->queue_);
+        sycl::free(this->view_.density, this->queue_);
+        track_release(account::device, this->bytes(), 4);
+    }
+
+    [[nodiscard]] frame_view const& view() const noexcept { return this->view_; }
+
+private:
+    size_t bytes() const noexcept {
+        return this->view_.size() * (3 * sizeof (color) + sizeof (uint32_t));
+    }
+
+private:
+    sycl::queue& queue_;
+    frame_view view_;
+};
+
+} // end of namespace frame_views
+
+#endif/*INCLUDE_FRAME_VIEW_HPP_2C7939E4_6F62_4421_8E41_54200F4E7E3F*/
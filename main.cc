@@ -3,7 +3,13 @@
 #include <filesystem>
 #include <complex>
 #include <numbers>
+#include <string>
 #include <string_view>
+#include <chrono>
+#include <span>
+#include <memory>
+#include <optional>
+#include <utility>
 #include <cstdlib>
 #include <cstring>
 
@@ -16,6 +22,16 @@
 #include "coroutines-ts.hpp"
 #include "wayland-client-helper.hpp"
 #include "versor.hpp"
+#include "bench.hpp"
+#include "frame-capture.hpp"
+#include "point-cloud.hpp"
+#include "render-stages.hpp"
+#include "render-graph.hpp"
+#include "post-filters.hpp"
+#include "density.hpp"
+#include "wayland-io-thread.hpp"
+#include "async-log.hpp"
+#include "control-block.hpp"
 
 inline namespace tuple_pretty_print {
 
@@ -110,17 +126,17 @@ int main() {
     static output_mode_args mode_args;
     static wl_output_listener output_listener {
         .geometry  = [](auto... args) noexcept {
-            std::cerr << "output geometry: " << std::tuple(args...) << std::endl;
+            log_debug("output geometry: {}", std::tuple(args...));
         },
         .mode = [](void* data, auto... args) noexcept {
             *reinterpret_cast<decltype (&mode_args)>(data) = std::tuple(data, args...);
-            std::cerr << "output mode: " << std::tuple(args...) << std::endl;
+            log_debug("output mode: {}", std::tuple(args...));
         },
         .done = [](auto... args) noexcept {
-            std::cerr << "output done: " << std::tuple(args...) << std::endl;
+            log_debug("output done: {}", std::tuple(args...));
         },
         .scale = [](auto... args) noexcept {
-            std::cerr << "output scale: " << std::tuple(args...) << std::endl;
+            log_debug("output scale: {}", std::tuple(args...));
         },
     };
     if (wl_output_add_listener(output.get(), &output_listener, &mode_args)) {
@@ -183,6 +199,8 @@ int main() {
         close(fd);
         return nil;
     }
+    // The mapping lives as long as the process.
+    track_acquire(account::shm, 4*cx*cy);
     return std::tuple(
         attach_unique(
             wl_shm_pool_create_buffer(
@@ -194,8 +212,49 @@ int main() {
         reinterpret_cast<color*>(data));
 }
 
+[[nodiscard]] inline sycl::queue select_queue(backend device) {
+    auto properties = sycl::property_list{sycl::property::queue::enable_profiling()};
+    switch (device) {
+    case backend::cpu:         return sycl::queue(sycl::cpu_selector_v, properties);
+    case backend::gpu:         return sycl::queue(sycl::gpu_selector_v, properties);
+    case backend::accelerator: return sycl::queue(sycl::accelerator_selector_v, properties);
+    default:                   return sycl::queue(properties);
+    }
+}
+
+// Everything allocated on the device, rebuilt as a whole when the backend
+// changes.  The point stream only exists while a point cloud is shown.
+struct device_context {
+    sycl::queue queue;
+    frame_resources frame;
+    std::optional<point_stream> stream;
+    density_accumulator accumulator;
+    size_t depth; // chunk slots of the point stream
+
+    device_context(backend device, size_t cx, size_t cy, size_t depth, bool points)
+        : queue(select_queue(device)),
+          frame(queue, cx, cy),
+          accumulator(queue),
+          depth(depth)
+        {
+            if (points) {
+                this->stream.emplace(this->queue, 1 << 20, depth);
+            }
+        }
+
+    [[nodiscard]] point_stream* points() noexcept {
+        return this->stream ? std::addressof(*this->stream) : nullptr;
+    }
+    void resize(size_t depth) {
+        this->depth = depth;
+        if (this->stream) {
+            this->stream->resize(depth);
+        }
+    }
+};
+
 [[nodiscard]]
-auto mainloop(size_t cx, size_t cy) -> std::generator<int> {
+auto mainloop(size_t cx, size_t cy) -> std::generator<int, accounted_frames<std::frame_pool<>>> {
     try {
         auto display = attach_unique(wl_display_connect(nullptr));
         if (!display) {
@@ -215,11 +274,11 @@ auto mainloop(size_t cx, size_t cy) -> std::generator<int> {
             std::cerr << "wl_seat_get_keyboard failed..." << std::endl;
             co_return ;
         }
-        uint32_t key_input = 0;
+        input_channel input;
         wl_keyboard_listener keyboard_listener{
             .keymap = [](auto...) noexcept { },
-            .enter = [](auto...) noexcept { std::cerr << "key enter." << std::endl; },
-            .leave = [](auto...) noexcept { std::cerr << "key leave." << std::endl; },
+            .enter = [](auto...) noexcept { log_debug("key enter."); },
+            .leave = [](auto...) noexcept { log_debug("key leave."); },
             .key = [](void *data,
                       wl_keyboard* keyboard_raw,
                       uint32_t serial,
@@ -227,14 +286,13 @@ auto mainloop(size_t cx, size_t cy) -> std::generator<int> {
                       uint32_t key,
                       uint32_t state) noexcept
             {
-                *reinterpret_cast<uint32_t*>(data) = key;
-                std::cerr << "key: " << key << '\t';
-                std::cerr << "  state: " << state << std::endl;
+                reinterpret_cast<input_channel*>(data)->push_key({key, state});
+                log_debug("key: {}\t  state: {}", key, state);
             },
             .modifiers = [](auto...) noexcept { },
-            .repeat_info = [](auto...) noexcept { std::cerr << "key repeat." << std::endl; },
+            .repeat_info = [](auto...) noexcept { log_debug("key repeat."); },
         };
-        if (wl_keyboard_add_listener(keyboard.get(), &keyboard_listener, &key_input)) {
+        if (wl_keyboard_add_listener(keyboard.get(), &keyboard_listener, &input)) {
             std::cerr << "wl_keyboard_add_listener failed..." << std::endl;
             co_return ;
         }
@@ -245,24 +303,27 @@ auto mainloop(size_t cx, size_t cy) -> std::generator<int> {
             std::cerr << "wl_seat_get_pointer failed..." << std::endl;
             co_return ;
         }
-        std::complex<float> pt(0, 0);
         wl_pointer_listener pointer_listener{
             .enter = [](auto...) noexcept { },
             .leave = [](auto...) noexcept { },
             .motion = [](auto data, auto, auto, wl_fixed_t x, wl_fixed_t y) noexcept {
-                *reinterpret_cast<decltype (&pt)>(data) = {
-                    static_cast<float>(wl_fixed_to_int(x)),
-                    static_cast<float>(wl_fixed_to_int(y)),
-                };
+                reinterpret_cast<input_channel*>(data)->update([=](auto& latest) noexcept {
+                    latest.pointer = {
+                        static_cast<float>(wl_fixed_to_int(x)),
+                        static_cast<float>(wl_fixed_to_int(y)),
+                    };
+                });
+            },
+            .button = [](auto, auto, auto, auto, uint32_t button, uint32_t state) noexcept {
+                log_debug("button: {}\t  state: {}", button, state);
             },
-            .button = [](auto...) noexcept { std::cerr << "button" << std::endl; },
             .axis = [](auto...) noexcept { },
             .frame = [](auto...) noexcept { },
             .axis_source = [](auto...) noexcept { },
             .axis_stop = [](auto...) noexcept { },
             .axis_discrete = [](auto...) noexcept { },
         };
-        if (wl_pointer_add_listener(pointer.get(), &pointer_listener, &pt)) {
+        if (wl_pointer_add_listener(pointer.get(), &pointer_listener, &input)) {
             std::cerr << "wl_pointer_add_listener failed..." << std::endl;
             co_return ;
         }
@@ -275,7 +336,7 @@ auto mainloop(size_t cx, size_t cy) -> std::generator<int> {
         }
         wl_buffer_listener buffer_listener{
             .release = [](auto...) noexcept {
-                std::cerr << "*** buffer released." << std::endl;
+                log_debug("*** buffer released.");
             },
         };
         if (wl_buffer_add_listener(buffer.get(), &buffer_listener, nullptr)) {
@@ -299,61 +360,229 @@ auto mainloop(size_t cx, size_t cy) -> std::generator<int> {
         wl_shell_surface_listener shell_surface_listener = {
             .ping = [](auto, auto shell_surface, auto serial) noexcept {
                 wl_shell_surface_pong(shell_surface, serial);
-                std::cout << "Pinged and ponged." << std::endl;
+                log_debug("Pinged and ponged.");
             },
-            .configure = [](auto, auto, auto, auto width, auto height) noexcept {
-                std::cout << "Configuring... (not supported yet)" << std::endl;
-                std::cout << "  width:  " << width  << std::endl;
-                std::cout << "  hieght: " << height << std::endl;
+            .configure = [](auto data, auto, auto, auto width, auto height) noexcept {
+                reinterpret_cast<input_channel*>(data)->update([=](auto& latest) noexcept {
+                    latest.width = width;
+                    latest.height = height;
+                });
+                log_info("Configuring... width: {}, height: {}", width, height);
             },
             .popup_done = [](auto...) noexcept {
-                std::cout << "Popup done." << std::endl;
+                log_debug("Popup done.");
             },
         };
-        if (wl_shell_surface_add_listener(shell_surface.get(), &shell_surface_listener, nullptr)) {
+        if (wl_shell_surface_add_listener(shell_surface.get(), &shell_surface_listener, &input)) {
             std::cerr << "wl_shell_surface_add_listener failed..." << std::endl;
             co_return ;
         }
         //wl_shell_surface_set_toplevel(shell_surface.get());
         wl_shell_surface_set_fullscreen(shell_surface.get(), 0, 60, output.get());
         /////////////////////////////////////////////////////////////////////////////
+        // Frame capture (optional)
+        std::unique_ptr<frame_capture> capture;
+        if (auto path = std::getenv("WLSYCL2_CAPTURE")) {
+            auto frames = std::getenv("WLSYCL2_CAPTURE_FRAMES");
+            capture = create_frame_capture(path, cx, cy, frames ? std::atoll(frames) : 600);
+        }
+        /////////////////////////////////////////////////////////////////////////////
+        // Point cloud (optional, replaces the spiral)
+        std::unique_ptr<mapped_point_cloud> cloud;
+        if (auto path = std::getenv("WLSYCL2_POINTS")) {
+            cloud = map_point_cloud(path);
+            if (!cloud) {
+                co_return ;
+            }
+        }
+        // Glow (optional): WLSYCL2_GLOW=<radius> for a Gaussian, or box:<radius>
+        auto glow_taps = box_taps(0);
+        if (auto glow = std::getenv("WLSYCL2_GLOW")) {
+            glow_taps = std::string_view(glow).starts_with("box:")
+                ? box_taps(std::atoi(glow + 4))
+                : gaussian_taps(std::atoi(glow));
+        }
+        auto device = backend::any;
+        auto context = std::make_unique<device_context>(device, cx, cy, 2, cloud != nullptr);
+        // Density (optional): WLSYCL2_DENSITY=atomic|privatized
+        auto mode = scatter_mode::last_writer;
+        if (auto density = std::getenv("WLSYCL2_DENSITY")) {
+            mode = std::string_view(density) == "atomic"
+                ? scatter_mode::global_atomic
+                : scatter_mode::privatized;
+        }
+        // Spiral math (optional): WLSYCL2_SPIRAL_MATH=precise|native|half|recurrence,
+        // or auto for the fastest one within WLSYCL2_SPIRAL_BUDGET (default 0.001)
+        // of the points landing on another pixel than with the precise one.
+        // The trial runs at the point count of the spiral, and again whenever
+        // the count or the backend changes.  The density modes evaluate the
+        // points one at a time, so recurrence is not available with them.
+        static constexpr size_t spiral_count = 16384;
+        auto math = spiral_math::precise;
+        bool auto_math = false;
+        bool pointwise = mode != scatter_mode::last_writer;
+        auto select_math = [&](size_t count, float scale) {
+            auto budget = std::getenv("WLSYCL2_SPIRAL_BUDGET");
+            auto trials = trial_spiral_math(context->queue, cx, cy, count, {cx / 2.0f, cy / 2.0f}, scale);
+            for (auto& trial : trials) {
+                log_info("spiral math {} ({} points): {} mismatches, {} ms",
+                         spiral_math_names[static_cast<size_t>(trial.math)],
+                         count, trial.mismatches, trial.seconds * 1e3);
+            }
+            auto selected = select_spiral_math(trials, count, budget ? std::atof(budget) : 0.001, pointwise);
+            log_info("spiral math: {}", spiral_math_names[static_cast<size_t>(selected)]);
+            return selected;
+        };
+        if (auto name = std::getenv("WLSYCL2_SPIRAL_MATH")) {
+            if (std::string_view(name) == "auto") {
+                auto_math = true;
+                math = select_math(spiral_count, 1.0f);
+            }
+            else if (auto parsed = parse_spiral_math(name, pointwise)) {
+                math = *parsed;
+            }
+            else {
+                std::cerr << "Unknown spiral math" << (pointwise ? " with WLSYCL2_DENSITY: " : ": ")
+                          << name << std::endl;
+                co_return ;
+            }
+        }
+        if (!auto_math) {
+            log_info("spiral math: {}", spiral_math_names[static_cast<size_t>(math)]);
+        }
+        auto graph = render_graph(
+            clear_stage{color(0xC0, 0x00)},
+            density_clear_stage{mode != scatter_mode::last_writer},
+            spiral_stage{
+                .active = !cloud,
+                .pt = {},
+                .count = spiral_count,
+                .mode = mode,
+                .accumulator = &context->accumulator,
+                .math = math,
+            },
+            point_cloud_stage{context->points(), cloud.get()},
+            tonemap_stage{mode != scatter_mode::last_writer, 0.5f},
+            blur_stage{glow_taps},
+            glow_stage{0 < glow_taps.radius, 1.0f},
+            present_stage{pixels});
+        /////////////////////////////////////////////////////////////////////////////
+        // Control block (optional): WLSYCL2_CONTROL=<path>, see --control
+        std::unique_ptr<control_channel> control;
+        if (auto path = std::getenv("WLSYCL2_CONTROL")) {
+            control = create_control_block(path, {
+                    .point_count = static_cast<uint32_t>(graph.node<spiral_stage>().count),
+                    .render_scale = graph.node<spiral_stage>().scale,
+                    .pipeline_depth = static_cast<uint32_t>(context->depth),
+                    .device = device,
+                    .background = std::bit_cast<uint32_t>(graph.node<clear_stage>().background),
+                });
+        }
+        auto apply = [&](control_params const& params) {
+            auto& spiral = graph.node<spiral_stage>();
+            auto count = spiral.count;
+            auto previous = device;
+            if (params.point_count) {
+                spiral.count = std::min<uint32_t>(params.point_count, 1 << 26);
+            }
+            if (0 < params.render_scale) {
+                spiral.scale = params.render_scale;
+            }
+            if (params.background) {
+                graph.node<clear_stage>().background = std::bit_cast<color>(params.background);
+            }
+            if (params.pipeline_depth) {
+                context->resize(std::min<uint32_t>(params.pipeline_depth, 16));
+            }
+            if (params.device != device) {
+                try {
+                    context = std::make_unique<device_context>(params.device, cx, cy,
+                                                               context->depth, cloud != nullptr);
+                    device = params.device;
+                    spiral.accumulator = &context->accumulator;
+                    graph.node<point_cloud_stage>().stream = context->points();
+                    graph.invalidate();
+                }
+                catch (sycl::exception& ex) {
+                    log_warn("backend {} is not available: {}", params.device, ex.what());
+                }
+            }
+            if (auto_math && (spiral.count != count || device != previous)) {
+                spiral.math = select_math(spiral.count, spiral.scale);
+            }
+        };
+        control_stats stats{};
+        /////////////////////////////////////////////////////////////////////////////
+        // Wayland I/O thread (optional): WLSYCL2_IO_THREAD=1
+        // Declared last so that it stops before anything its listeners touch.
+        std::unique_ptr<display_thread> io;
+        if (auto threaded = std::getenv("WLSYCL2_IO_THREAD"); threaded && *threaded != '0') {
+            io = std::make_unique<display_thread>(display.get());
+        }
+        auto next_events = [&]() noexcept {
+            return io ? io->wait_events() : wl_display_dispatch(display.get()) != -1;
+        };
+        /////////////////////////////////////////////////////////////////////////////
         // Main loop
-        while (wl_display_dispatch(display.get()) != -1) {
+        std::pair<int32_t, int32_t> configured{};
+        while (next_events()) {
             co_yield 0;
-            if (1 == key_input) {
+            bool quit = false;
+            while (auto key = input.pop_key()) {
+                quit |= (1 == key->key);
+            }
+            if (quit) {
                 break;
             }
             /////////////////////////////////////////////////////////////////////////////
-            auto dim_pixels = sycl::range<2>{cy, cx};
-            auto dev_pixels = sycl::buffer{pixels, dim_pixels};
-            sycl::queue().submit([&](sycl::handler& h) {
-                auto a = dev_pixels.get_access<sycl::access::mode::write>(h);
-                h.parallel_for(dim_pixels, [=](auto idx) {
-                    a[idx] = color(0xC0, 0x00);
-                });
-            });
-            auto resolution = sycl::range<1>{16384};
-            sycl::queue().submit([&](sycl::handler& h) {
-                auto a = dev_pixels.get_access<sycl::access::mode::read_write>(h);
-                h.parallel_for(resolution, [=](auto idx) {
-                    static constexpr float pi = std::numbers::pi_v<float>;
-                    static constexpr float phi = std::numbers::phi_v<float>;
-                    float i = (1 + idx);
-                    std::complex<float> c = pt + std::polar<float>(std::sqrt(i), i*2*pi/phi);
-                    if (0.0f <= c.real() && c.real() < cx) {
-                        size_t y = std::round(c.imag());
-                        size_t x = std::round(c.real());
-                        a[{y, x}] = color(0xC0,
-                                          0xC0 - 0xC0*idx[0]/resolution[0]);
-                    }
-                });
-            });
+            auto snapshot = input.snapshot();
+            graph.node<spiral_stage>().pt = snapshot.pointer;
+            // The buffer keeps its size; a configure asking for another one
+            // is only reported, once per distinct size.
+            if (std::pair(snapshot.width, snapshot.height) != configured) {
+                configured = {snapshot.width, snapshot.height};
+                if (0 < snapshot.width && 0 < snapshot.height &&
+                    (static_cast<size_t>(snapshot.width) != cx || static_cast<size_t>(snapshot.height) != cy))
+                {
+                    log_warn("surface configured to {}x{}, the buffer stays {}x{}",
+                             snapshot.width, snapshot.height, cx, cy);
+                }
+            }
+            if (control) {
+                if (auto params = control->poll()) {
+                    apply(*params);
+                    ++stats.applied;
+                }
+            }
+            auto t0 = std::chrono::steady_clock::now();
+            auto rebuilt = graph.execute(context->queue, context->frame.view());
+            if (control) {
+                auto t1 = std::chrono::steady_clock::now();
+                stats.last_ms = std::chrono::duration<float, std::milli>(t1 - t0).count();
+                stats.average_ms += (stats.last_ms - stats.average_ms) / ++stats.frames;
+                stats.rebuilt = rebuilt;
+                stats.device = device;
+                control->publish(stats);
+            }
+            if (capture) {
+                capture->snapshot(pixels, rebuilt & resource::presented
+                                  ? damage_rect{0, 0, cx, cy}
+                                  : damage_rect{});
+            }
             /////////////////////////////////////////////////////////////////////////////
-            wl_surface_damage(surface.get(), 0, 0, cx, cy);
+            if (rebuilt & resource::presented) {
+                wl_surface_damage(surface.get(), 0, 0, cx, cy);
+            }
             wl_surface_attach(surface.get(), buffer.get(), 0, 0);
             wl_surface_commit(surface.get());
             wl_display_flush(display.get());
         }
+        graph.report(std::cout);
+        resource_ledger::instance().report(std::cout);
+        if (capture) {
+            std::cout << "capture: " << capture->written() << " frames written, "
+                      << capture->dropped() << " dropped" << std::endl;
+        }
         co_return ;
     }
     catch (std::exception& ex) {
@@ -365,7 +594,248 @@ auto mainloop(size_t cx, size_t cy) -> std::generator<int> {
     co_return ;
 }
 
-int main() {
+inline namespace benchmarks {
+
+template <class Allocator>
+auto iota(int n) -> std::generator<int, Allocator> {
+    for (int i = 0; i < n; ++i) {
+        co_yield i;
+    }
+}
+
+template <class Allocator>
+void bench_generator(std::string_view title) {
+    // Many short-lived generators: dominated by frame allocation.
+    static constexpr int churn = 1 << 20;
+    measure(std::string(title) + " churn", churn, [] {
+        for (int i = 0; i < churn; ++i) {
+            for (auto item : iota<Allocator>(4)) {
+                do_not_optimize(item);
+            }
+        }
+    });
+    // A single long-lived generator: dominated by resume/yield.
+    static constexpr int yields = 1 << 24;
+    measure(std::string(title) + " yield", yields, [] {
+        for (auto item : iota<Allocator>(yields)) {
+            do_not_optimize(item);
+        }
+    });
+}
+
+inline void bench_point_stream() {
+    static constexpr size_t count = 1 << 23;
+    auto path = (std::filesystem::temp_directory_path() / "wlsycl2-bench.wlpc").string();
+    {
+        std::vector<point_record> points(count);
+        uint32_t seed = 1;
+        auto next = [&seed] { return seed = seed * 1664525u + 1013904223u; };
+        for (auto& p : points) {
+            p = {static_cast<float>(next() % 1920),
+                 static_cast<float>(next() % 1080),
+                 next() | 0xFF000000u};
+        }
+        if (!write_point_cloud(path, points)) {
+            return ;
+        }
+    }
+    if (auto cloud = map_point_cloud(path)) {
+        auto queue = sycl::queue();
+        auto frame = frame_resources(queue, 1920, 1080);
+        for (size_t depth : {1, 2, 3}) {
+            auto stream = point_stream(queue, 1 << 20, depth);
+            measure("point stream (depth " + std::to_string(depth) + ")", count, [&] {
+                stream.scatter(frame.view(), *cloud, {}).last.wait();
+            });
+        }
+    }
+    std::filesystem::remove(path);
+}
+
+// The theoretical peak memory bandwidth of the device [bytes/sec], from the
+// Intel device info extension or WLSYCL2_PEAK_GBPS; 0 when unknown.
+inline double peak_bandwidth(sycl::device const& device) {
+    if (auto gbps = std::getenv("WLSYCL2_PEAK_GBPS")) {
+        return std::atof(gbps) * 1e9;
+    }
+#if defined (SYCL_EXT_INTEL_DEVICE_INFO) && SYCL_EXT_INTEL_DEVICE_INFO >= 6
+    if (device.has(sycl::aspect::ext_intel_memory_clock_rate) &&
+        device.has(sycl::aspect::ext_intel_memory_bus_width))
+    {
+        namespace info = sycl::ext::intel::info::device;
+        double mhz  = device.get_info<info::memory_clock_rate>();
+        double bits = device.get_info<info::memory_bus_width>();
+        return mhz * 1e6 * bits / 8;
+    }
+#endif
+    return 0;
+}
+
+inline void bench_filters() {
+    auto queue = sycl::queue();
+    auto peak = peak_bandwidth(queue.get_device());
+    for (auto [title, cx, cy] : {std::tuple("1080p", 1920, 1080), std::tuple("4K", 3840, 2160)}) {
+        auto frame = frame_resources(queue, cx, cy);
+        queue.fill(frame.view().pixels, color(0xC0, 0x40), frame.view().size()).wait();
+        for (auto [kind, taps] : {std::tuple("gaussian", gaussian_taps(4)),
+                                  std::tuple("gaussian", gaussian_taps(16)),
+                                  std::tuple("box", box_taps(16))})
+        {
+            auto blur = blur_stage{taps};
+            auto t = measure(std::string("blur ") + title + " " + kind +
+                             " r=" + std::to_string(taps.radius), cx * cy, [&] {
+                blur.submit(queue, frame.view(), {}).last.wait();
+            });
+            // Effective: as if each pass read and wrote every pixel once.
+            // Actual: what the passes move, the halos of the tiles included.
+            auto effective = 2 * 2 * sizeof (color) * cx * cy / t;
+            auto bytes = convolve_tile<1>::bytes(cx, cy, taps.radius) +
+                         convolve_tile<0>::bytes(cx, cy, taps.radius);
+            auto actual = bytes / t;
+            std::cout << "  effective " << effective * 1e-9 << " GB/s, actual "
+                      << actual * 1e-9 << " GB/s";
+            if (peak) {
+                std::cout << " (" << 100 * actual / peak << "% of "
+                          << peak * 1e-9 << " GB/s peak)";
+            }
+            std::cout << std::endl;
+        }
+    }
+}
+
+inline void bench_density() {
+    auto queue = sycl::queue();
+    auto frame = frame_resources(queue, 1920, 1080);
+    auto accumulator = density_accumulator(queue);
+    queue.memset(frame.view().density, 0, frame.view().size() * sizeof (uint32_t)).wait();
+    for (size_t count : {1 << 14, 1 << 18, 1 << 22, 1 << 24}) {
+        // Squeeze the whole spiral into a disc of radius 500 around the centre.
+        auto spiral = spiral_stage{
+            .active = true,
+            .pt = {960, 540},
+            .count = count,
+            .scale = 500 / std::sqrt(static_cast<float>(count)),
+            .accumulator = &accumulator,
+        };
+        for (auto [title, mode] : {std::tuple("last writer",   scatter_mode::last_writer),
+                                   std::tuple("global atomic", scatter_mode::global_atomic),
+                                   std::tuple("privatized",    scatter_mode::privatized)})
+        {
+            spiral.mode = mode;
+            measure(std::string("density ") + title + " (" + std::to_string(count) + " points)", count, [&] {
+                spiral.submit(queue, frame.view(), {}).last.wait();
+            });
+        }
+    }
+}
+
+inline void bench_spiral_math() {
+    auto queue = sycl::queue();
+    auto frame = frame_resources(queue, 1920, 1080);
+    for (size_t count : {1 << 14, 1 << 20, 1 << 24}) {
+        // The whole spiral within a disc of radius 500 around the centre.
+        auto scale = 500 / std::sqrt(static_cast<float>(count));
+        auto trials = trial_spiral_math(queue, 1920, 1080, count, {960, 540}, scale);
+        for (auto& trial : trials) {
+            auto name = spiral_math_names[static_cast<size_t>(trial.math)];
+            auto spiral = spiral_stage{
+                .active = true,
+                .pt = {960, 540},
+                .count = count,
+                .scale = scale,
+                .math = trial.math,
+            };
+            measure("spiral " + std::string(name) + " (" + std::to_string(count) + " points)", count, [&] {
+                spiral.submit(queue, frame.view(), {}).last.wait();
+            });
+            std::cout << "  " << trial.mismatches << " pixel mismatches ("
+                      << 100.0 * trial.mismatches / count << "%)" << std::endl;
+        }
+        auto fastest = select_spiral_math(trials, count, 0.001);
+        std::cout << "  fastest within 0.1%: "
+                  << spiral_math_names[static_cast<size_t>(fastest)] << std::endl;
+    }
+}
+
+inline int run_benchmarks(std::string_view filter) {
+    static constexpr std::pair<std::string_view, void (*)()> table[] = {
+        {"generator", [] {
+            bench_generator<std::frame_pool<>>("generator (frame_pool)");
+            bench_generator<std::allocator<std::byte>>("generator (operator new)");
+        }},
+        {"points", bench_point_stream},
+        {"filters", bench_filters},
+        {"density", bench_density},
+        {"spiral", bench_spiral_math},
+    };
+    for (auto [name, run] : table) {
+        if (filter.empty() || name == filter) {
+            run();
+        }
+    }
+    return 0;
+}
+
+} // end of namespace benchmarks
+
+// --control <path> [count=<n>] [scale=<f>] [depth=<n>] [backend=any|cpu|gpu|accelerator]
+//                  [background=<argb hex>]
+// Updates the control block of a running instance and prints its statistics.
+inline int run_control(std::string_view path, std::span<char*> settings) {
+    auto control = open_control_block(path);
+    if (!control) {
+        return 1;
+    }
+    auto params = control->params();
+    for (std::string_view setting : settings) {
+        auto eq = setting.find('=');
+        auto key = setting.substr(0, eq);
+        auto value = std::string(eq == setting.npos ? "" : setting.substr(eq + 1));
+        if      (key == "count")      { params.point_count = std::stoul(value); }
+        else if (key == "scale")      { params.render_scale = std::stof(value); }
+        else if (key == "depth")      { params.pipeline_depth = std::stoul(value); }
+        else if (key == "background") { params.background = std::stoul(value, nullptr, 16); }
+        else if (key == "backend") {
+            static constexpr std::string_view names[] = {"any", "cpu", "gpu", "accelerator"};
+            auto it = std::find(std::begin(names), std::end(names), value);
+            if (it == std::end(names)) {
+                std::cerr << "Unknown backend: " << value << std::endl;
+                return 1;
+            }
+            params.device = static_cast<backend>(it - std::begin(names));
+        }
+        else {
+            std::cerr << "Unknown setting: " << setting << std::endl;
+            return 1;
+        }
+    }
+    if (!settings.empty()) {
+        control->update(params);
+    }
+    auto stats = control->stats();
+    std::cout << "frames:  " << stats.frames << std::endl;
+    std::cout << "applied: " << stats.applied << std::endl;
+    std::cout << "last:    " << stats.last_ms << " ms" << std::endl;
+    std::cout << "average: " << stats.average_ms << " ms" << std::endl;
+    std::cout << "rebuilt: " << stats.rebuilt << std::endl;
+    std::cout << "backend: " << static_cast<uint32_t>(stats.device) << std::endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (1 < argc && std::string_view(argv[1]) == "--bench") {
+        return run_benchmarks(2 < argc ? argv[2] : "");
+    }
+    if (2 < argc && std::string_view(argv[1]) == "--control") {
+        try {
+            return run_control(argv[2], std::span(argv + 3, argc - 3));
+        }
+        catch (std::exception& ex) {
+            std::cerr << "Invalid setting: " << ex.what() << std::endl;
+            return 1;
+        }
+    }
+    proxy_observer = track_proxy;
     for ([[maybe_unused]] auto item : mainloop(640, 480)) {
     }
     return 0;
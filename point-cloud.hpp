@@ -0,0 +1,179 @@
+#ifndef INCLUDE_POINT_CLOUD_HPP_8E40C0F5_7AF7_467F_AB58_45A9F7DE16EB
+#define INCLUDE_POINT_CLOUD_HPP_8E40C0F5_7AF7_467F_AB58_45A9F7DE16EB
+
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <cstdint>
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "coroutines-ts.hpp"
+#include "resource-accounting.hpp"
+
+inline namespace point_cloud_io
+{
+
+// The on-disk layout is a point_cloud_header followed by `count` packed
+// point_records, all in host byte order.
+struct point_record {
+    float x;
+    float y;
+    uint32_t argb;
+};
+static_assert(sizeof (point_record) == 12);
+
+struct point_cloud_header {
+    static constexpr char signature[4] = {'W', 'L', 'P', 'C'};
+    static constexpr uint32_t current_version = 1;
+
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+    float min_x, min_y; // bounds of all the records
+    float max_x, max_y;
+};
+static_assert(sizeof (point_cloud_header) == 32);
+
+// A read-only mapping of a point cloud file.  Records are paged in on demand,
+// so the file may be much larger than both host and device memory.
+class mapped_point_cloud {
+public:
+    mapped_point_cloud(void* data, size_t size) noexcept
+        : data_(data), size_(size)
+        {
+            track_acquire(account::mapped_files, size);
+        }
+    mapped_point_cloud(mapped_point_cloud const&) = delete;
+    mapped_point_cloud& operator=(mapped_point_cloud const&) = delete;
+    ~mapped_point_cloud() noexcept {
+        munmap(this->data_, this->size_);
+        track_release(account::mapped_files, this->size_);
+    }
+
+    [[nodiscard]] point_cloud_header const& header() const noexcept {
+        return *static_cast<point_cloud_header const*>(this->data_);
+    }
+    [[nodiscard]] std::span<point_record const> records() const noexcept {
+        auto first = reinterpret_cast<point_record const*>(&this->header() + 1);
+        return {first, this->header().count};
+    }
+
+    // Yields consecutive runs of at most n records, asking the kernel to read
+    // ahead the run after the one being yielded.
+    [[nodiscard]] auto chunks(size_t n) const
+        -> std::generator<std::span<point_record const>, accounted_frames<std::frame_pool<>>>
+    {
+        auto all = this->records();
+        for (size_t i = 0; i < all.size(); i += n) {
+            auto chunk = all.subspan(i, std::min(n, all.size() - i));
+            if (i + n < all.size()) {
+                this->advise(all.subspan(i + n, std::min(n, all.size() - i - n)), MADV_WILLNEED);
+            }
+            co_yield chunk;
+        }
+    }
+
+private:
+    void advise(std::span<point_record const> range, int advice) const noexcept {
+        static auto const page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        auto first = reinterpret_cast<uintptr_t>(range.data()) & ~(page - 1);
+        auto last  = reinterpret_cast<uintptr_t>(range.data() + range.size());
+        madvise(reinterpret_cast<void*>(first), last - first, advice);
+    }
+
+private:
+    void* data_;
+    size_t size_;
+};
+
+[[nodiscard]] inline auto map_point_cloud(std::string_view path) noexcept {
+    std::unique_ptr<mapped_point_cloud> nil;
+    int fd = open(std::string(path).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Failed to open the point cloud..." << std::endl;
+        return nil;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof (point_cloud_header)) {
+        std::cerr << "The point cloud is too short..." << std::endl;
+        close(fd);
+        return nil;
+    }
+    size_t size = st.st_size;
+    auto data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        std::cerr << "Failed to mmap the point cloud..." << std::endl;
+        return nil;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+    auto cloud = std::make_unique<mapped_point_cloud>(data, size);
+    auto& header = cloud->header();
+    if (std::memcmp(header.magic, header.signature, sizeof (header.magic)) ||
+        header.version != header.current_version)
+    {
+        std::cerr << "Not a point cloud file..." << std::endl;
+        return nil;
+    }
+    if ((size - sizeof (header)) / sizeof (point_record) < header.count) {
+        std::cerr << "The point cloud is truncated..." << std::endl;
+        return nil;
+    }
+    return cloud;
+}
+
+// Writes `records` in the format read by map_point_cloud().
+[[nodiscard]] inline bool write_point_cloud(std::string_view path,
+                                            std::span<point_record const> records) noexcept
+{
+    point_cloud_header header = {
+        .magic = {'W', 'L', 'P', 'C'},
+        .version = point_cloud_header::current_version,
+        .count = records.size(),
+        .min_x = std::numeric_limits<float>::max(),
+        .min_y = std::numeric_limits<float>::max(),
+        .max_x = std::numeric_limits<float>::lowest(),
+        .max_y = std::numeric_limits<float>::lowest(),
+    };
+    for (auto& r : records) {
+        header.min_x = std::min(header.min_x, r.x);
+        header.min_y = std::min(header.min_y, r.y);
+        header.max_x = std::max(header.max_x, r.x);
+        header.max_y = std::max(header.max_y, r.y);
+    }
+    int fd = open(std::string(path).c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to create the point cloud..." << std::endl;
+        return false;
+    }
+    auto write_all = [fd](void const* data, size_t size) noexcept {
+        for (auto p = static_cast<char const*>(data); size; ) {
+            auto n = write(fd, p, size);
+            if (n < 0) {
+                return false;
+            }
+            p += n;
+            size -= n;
+        }
+        return true;
+    };
+    bool ok = write_all(&header, sizeof (header)) && write_all(records.data(), records.size_bytes());
+    close(fd);
+    if (!ok) {
+        std::cerr << "Failed to write the point cloud..." << std::endl;
+    }
+    return ok;
+}
+
+} // end of namespace point_cloud_io
+
+#endif/*INCLUDE_POINT_CLOUD_HPP_8E40C0F5_7AF7_467F_AB58_45A9F7DE16EB*/
@@ -0,0 +1,190 @@
+#ifndef INCLUDE_POST_FILTERS_HPP_B94ADE9C_3987_409D_B260_7F6C7AAB0961
+#define INCLUDE_POST_FILTERS_HPP_B94ADE9C_3987_409D_B260_7F6C7AAB0961
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <string_view>
+#include <tuple>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#include <CL/sycl.hpp>
+
+#include "versor.hpp"
+#include "frame-view.hpp"
+
+inline namespace post_filters
+{
+
+// Symmetric 1-D filter taps: weights[0] is the centre, weights[d] applies at
+// both -d and +d.
+struct filter_taps {
+    static constexpr int max_radius = 32;
+
+    int radius;
+    float weights[max_radius + 1];
+
+    friend bool operator == (filter_taps const&, filter_taps const&) = default;
+};
+
+[[nodiscard]] inline filter_taps box_taps(int radius) noexcept {
+    filter_taps taps{std::clamp(radius, 0, filter_taps::max_radius), {}};
+    for (int d = 0; d <= taps.radius; ++d) {
+        taps.weights[d] = 1.0f / (2*taps.radius + 1);
+    }
+    return taps;
+}
+
+[[nodiscard]] inline filter_taps gaussian_taps(int radius) noexcept {
+    filter_taps taps{std::clamp(radius, 0, filter_taps::max_radius), {}};
+    // The kernel is cut off at 3 sigma.
+    float sigma = std::max(taps.radius / 3.0f, 0.5f);
+    float sum = 0;
+    for (int d = 0; d <= taps.radius; ++d) {
+        taps.weights[d] = std::exp(-0.5f * d*d / (sigma*sigma));
+        sum += (d == 0 ? 1 : 2) * taps.weights[d];
+    }
+    for (int d = 0; d <= taps.radius; ++d) {
+        taps.weights[d] /= sum;
+    }
+    return taps;
+}
+
+using channels = std::array<float, 4>;
+
+inline channels unpack(color c) noexcept {
+    auto bytes = std::bit_cast<std::array<uint8_t, 4>>(c);
+    return {float(bytes[0]), float(bytes[1]), float(bytes[2]), float(bytes[3])};
+}
+inline color pack(channels const& ch) noexcept {
+    std::array<uint8_t, 4> bytes;
+    for (size_t i = 0; i < 4; ++i) {
+        bytes[i] = static_cast<uint8_t>(std::clamp(ch[i] + 0.5f, 0.0f, 255.0f));
+    }
+    return std::bit_cast<color>(bytes);
+}
+
+// The work-group tile of a pass along Axis (0: vertical, 1: horizontal).
+// Each of `items` work-items along the axis produces `outputs` pixels, so a
+// tile is `along` pixels long in the direction of the filter and `across`
+// wide, and the halo adds only 2r/along to what is read.
+template <int Axis>
+struct convolve_tile {
+    static constexpr size_t items = 16;
+    static constexpr size_t outputs = 8;
+    static constexpr size_t along = items * outputs;
+    static constexpr size_t across = 16;
+    // Pixels produced by a work-group, and its work-items, as height x width.
+    static constexpr size_t by = Axis == 0 ? along : across;
+    static constexpr size_t bx = Axis == 0 ? across : along;
+    static constexpr size_t ly = Axis == 0 ? items : across;
+    static constexpr size_t lx = Axis == 0 ? across : items;
+
+    // The global memory traffic of one pass: the staged tiles and the output.
+    static size_t bytes(size_t cx, size_t cy, long r) noexcept {
+        size_t groups = (cy + by - 1) / by * ((cx + bx - 1) / bx);
+        size_t staged = (by + (Axis == 0 ? 2*r : 0)) * (bx + (Axis == 1 ? 2*r : 0));
+        return (groups * staged + cx * cy) * sizeof (color);
+    }
+};
+
+// One pass of a separable filter along Axis.  Each work-group stages its tile
+// plus the halo along Axis in local memory; see convolve_tile.
+template <int Axis>
+sycl::event convolve(sycl::queue& queue, color const* src, color* dst,
+                     size_t cx, size_t cy, filter_taps const& taps,
+                     std::vector<sycl::event> const& deps)
+{
+    using tile_t = convolve_tile<Axis>;
+    static constexpr size_t by = tile_t::by;
+    static constexpr size_t bx = tile_t::bx;
+    static constexpr size_t items = tile_t::items;
+    long r = taps.radius;
+    size_t th = by + (Axis == 0 ? 2*r : 0);
+    size_t tw = bx + (Axis == 1 ? 2*r : 0);
+    return queue.submit([&](sycl::handler& h) {
+        h.depends_on(deps);
+        auto tile = sycl::local_accessor<color, 1>(sycl::range<1>{th * tw}, h);
+        auto nd = sycl::nd_range<2>{{(cy + by - 1) / by * tile_t::ly, (cx + bx - 1) / bx * tile_t::lx},
+                                    {tile_t::ly, tile_t::lx}};
+        h.parallel_for(nd, [=](sycl::nd_item<2> it) {
+            long oy = static_cast<long>(it.get_group(0) * by) - (Axis == 0 ? r : 0);
+            long ox = static_cast<long>(it.get_group(1) * bx) - (Axis == 1 ? r : 0);
+            for (size_t j = it.get_local_linear_id(); j < th * tw; j += tile_t::ly * tile_t::lx) {
+                // Clamp to the edge of the frame.
+                auto y = std::clamp<long>(oy + static_cast<long>(j / tw), 0, cy - 1);
+                auto x = std::clamp<long>(ox + static_cast<long>(j % tw), 0, cx - 1);
+                tile[j] = src[y * cx + x];
+            }
+            sycl::group_barrier(it.get_group());
+            // Neighbouring work-items produce neighbouring pixels at each step.
+            for (size_t k = 0; k < tile_t::outputs; ++k) {
+                auto ty = it.get_local_id(0) + (Axis == 0 ? k * items : 0);
+                auto tx = it.get_local_id(1) + (Axis == 1 ? k * items : 0);
+                auto y = it.get_group(0) * by + ty;
+                auto x = it.get_group(1) * bx + tx;
+                if (y < cy && x < cx) {
+                    auto ly = ty + (Axis == 0 ? r : 0);
+                    auto lx = tx + (Axis == 1 ? r : 0);
+                    channels sum{};
+                    for (long d = -r; d <= r; ++d) {
+                        auto c = unpack(tile[(ly + (Axis == 0 ? d : 0)) * tw + lx + (Axis == 1 ? d : 0)]);
+                        auto w = taps.weights[d < 0 ? -d : d];
+                        for (size_t i = 0; i < 4; ++i) {
+                            sum[i] += w * c[i];
+                        }
+                    }
+                    dst[y * cx + x] = pack(sum);
+                }
+            }
+        });
+    });
+}
+
+// Blurs the framebuffer into the bloom buffer.
+struct blur_stage {
+    static constexpr std::string_view name = "blur";
+    static constexpr bool elementwise = false;
+    static constexpr uint32_t reads  = resource::framebuffer;
+    static constexpr uint32_t writes = resource::bloom;
+
+    filter_taps taps;
+
+    bool enabled() const noexcept { return 0 < this->taps.radius; }
+    auto key() const noexcept { return this->taps; }
+    node_events submit(sycl::queue& queue, frame_view const& view,
+                       std::vector<sycl::event> const& deps) const
+    {
+        auto h = convolve<1>(queue, view.pixels, view.scratch, view.cx, view.cy, this->taps, deps);
+        auto v = convolve<0>(queue, view.scratch, view.bloom, view.cx, view.cy, this->taps, {h});
+        return {h, v};
+    }
+};
+
+// Adds the bloom buffer back onto the framebuffer.
+struct glow_stage {
+    static constexpr std::string_view name = "glow";
+    static constexpr bool elementwise = true;
+    static constexpr uint32_t reads  = resource::framebuffer | resource::bloom;
+    static constexpr uint32_t writes = resource::framebuffer;
+
+    bool active;
+    float gain;
+
+    bool enabled() const noexcept { return this->active; }
+    auto key() const noexcept { return std::tuple(this->active, this->gain); }
+    void operator()(frame_view const& view, size_t i) const noexcept {
+        auto c = unpack(view.bloom[i]);
+        for (auto& ch : c) {
+            ch *= this->gain;
+        }
+        c[3] = 0; // keep the alpha of the framebuffer
+        view.pixels[i] += pack(c);
+    }
+};
+
+} // end of namespace post_filters
+
+#endif/*INCLUDE_POST_FILTERS_HPP_B94ADE9C_3987_409D_B260_7F6C7AAB0961*/
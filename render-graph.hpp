@@ -0,0 +1,328 @@
+#ifndef INCLUDE_RENDER_GRAPH_HPP_F705AB5E_A1FF_426B_B051_92E0AEBF66B7
+#define INCLUDE_RENDER_GRAPH_HPP_F705AB5E_A1FF_426B_B051_92E0AEBF66B7
+
+#include <iostream>
+#include <iomanip>
+#include <array>
+#include <tuple>
+#include <vector>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <cstdint>
+
+#include <CL/sycl.hpp>
+
+#include "render-stages.hpp"
+
+inline namespace render_graph_executor
+{
+
+// A node declares the resources it touches and how it runs:
+//
+//   static constexpr std::string_view name;
+//   static constexpr bool elementwise;     // one work-item per frame pixel
+//   static constexpr uint32_t reads, writes;
+//   auto key() const;                      // compared to decide on skipping
+//   bool enabled() const;                  // optional
+//
+// and either `void operator()(frame_view const&, size_t i) const` when it is
+// elementwise, or `node_events submit(queue&, frame_view const&, deps) const`.
+template <class T>
+concept render_node = requires (T const& node) {
+    { T::name } -> std::convertible_to<std::string_view>;
+    { T::elementwise } -> std::convertible_to<bool>;
+    { T::reads } -> std::convertible_to<uint32_t>;
+    { T::writes } -> std::convertible_to<uint32_t>;
+    node.key();
+};
+
+struct node_timing {
+    size_t runs = 0;
+    size_t skips = 0;
+    double last_ms = 0;
+    double total_ms = 0;
+};
+
+// A fixed pipeline of nodes, built once and executed every frame.
+//
+// Runs of adjacent elementwise nodes are fused into a single kernel.  A node
+// is skipped when its key is unchanged and nothing it reads was rebuilt;
+// however, once any writer of a resource runs, every writer of that resource
+// runs again, since the resource is composed by all of them in order.  A
+// disabled node rebuilds nothing, except in the frame it was disabled in,
+// when what it had written has to be composed again without it.  The
+// commands are chained through explicit events derived from the declared
+// resources, and per-node device times are kept when the queue profiles.
+template <render_node... Nodes>
+class render_graph {
+    static constexpr size_t N = sizeof... (Nodes);
+    static constexpr bool elementwise[] = {Nodes::elementwise...};
+    static constexpr uint32_t reads[]   = {Nodes::reads...};
+    static constexpr uint32_t writes[]  = {Nodes::writes...};
+
+    // group_begin[i]: the first node of the fused group containing node i.
+    static constexpr auto group_begin = [] {
+        std::array<size_t, N> begin{};
+        for (size_t i = 0; i < N; ++i) {
+            begin[i] = (0 < i && elementwise[i-1] && elementwise[i]) ? begin[i-1] : i;
+        }
+        return begin;
+    }();
+    // group_end[i]: one past the last node of the fused group containing node i.
+    static constexpr auto group_end = [] {
+        std::array<size_t, N> end{};
+        for (size_t i = N; 0 < i--; ) {
+            end[i] = (i+1 < N && elementwise[i] && elementwise[i+1]) ? end[i+1] : i+1;
+        }
+        return end;
+    }();
+
+    struct resource_state {
+        std::optional<sycl::event> writer;
+        std::vector<sycl::event> readers;
+    };
+
+public:
+    explicit render_graph(Nodes... nodes) noexcept
+        : nodes_(std::move(nodes)...)
+        {
+        }
+
+    template <class T>
+    [[nodiscard]] T& node() noexcept { return std::get<T>(this->nodes_); }
+
+    // Submits one frame and waits for it.  Returns the resources rebuilt.
+    uint32_t execute(sycl::queue& queue, frame_view const& view) {
+        auto dirty = this->update_keys(std::make_index_sequence<N>());
+        auto active = this->enabled_nodes(std::make_index_sequence<N>());
+        std::array<bool, N> contributes;
+        for (size_t i = 0; i < N; ++i) {
+            contributes[i] = active[i] || this->was_active_[i];
+        }
+        this->was_active_ = active;
+        uint32_t rebuilt = 0;
+        for (bool changed = true; changed; ) {
+            changed = false;
+            for (size_t i = 0; i < N; ++i) {
+                if (!dirty[i] && ((reads[i] | writes[i]) & rebuilt)) {
+                    dirty[i] = changed = true;
+                }
+                if (dirty[i] && !dirty[group_begin[i]]) {
+                    dirty[group_begin[i]] = changed = true;
+                }
+                if (dirty[group_begin[i]] && !dirty[i]) {
+                    dirty[i] = changed = true;
+                }
+                if (dirty[i] && contributes[i] && (rebuilt | writes[i]) != rebuilt) {
+                    rebuilt |= writes[i];
+                    changed = true;
+                }
+            }
+        }
+        std::array<resource_state, 32> resources;
+        std::array<std::optional<node_events>, N> submitted;
+        this->submit_from<0>(queue, view, dirty, resources, submitted);
+        for (auto& events : submitted) {
+            if (events) {
+                events->last.wait();
+            }
+        }
+        this->collect_timings(queue, submitted);
+        return rebuilt;
+    }
+
+    // Forgets the keys, so that every node runs in the next frame; for when
+    // the resources behind the frame_view were replaced.
+    void invalidate() noexcept {
+        this->keys_ = {};
+    }
+
+    [[nodiscard]] node_timing const& timing(size_t i) const noexcept {
+        return this->timings_[group_begin[i]];
+    }
+
+    void report(std::ostream& output) const {
+        static constexpr std::string_view names[] = {Nodes::name...};
+        for (size_t i = 0; i < N; i = group_end[i]) {
+            std::string title;
+            for (size_t j = i; j < group_end[i]; ++j) {
+                title += (j == i ? "" : "+");
+                title += names[j];
+            }
+            auto& t = this->timings_[i];
+            output << std::setw(24) << std::left << title << std::right
+                   << " runs: "    << std::setw(6) << t.runs
+                   << " skipped: " << std::setw(6) << t.skips
+                   << " last: "    << std::setw(9) << t.last_ms << " ms"
+                   << " avg: "     << std::setw(9) << (t.runs ? t.total_ms / t.runs : 0) << " ms"
+                   << std::endl;
+        }
+    }
+
+private:
+    template <size_t... I>
+    std::array<bool, N> update_keys(std::index_sequence<I...>) {
+        return {this->update_key<I>()...};
+    }
+    template <size_t I>
+    bool update_key() {
+        auto key = std::get<I>(this->nodes_).key();
+        auto& last = std::get<I>(this->keys_);
+        if (last && *last == key) {
+            return false;
+        }
+        last = std::move(key);
+        return true;
+    }
+
+    template <size_t... I>
+    std::array<bool, N> enabled_nodes(std::index_sequence<I...>) const noexcept {
+        return {enabled(std::get<I>(this->nodes_))...};
+    }
+
+    static bool enabled(auto const& node) noexcept {
+        if constexpr (requires { node.enabled(); }) {
+            return node.enabled();
+        }
+        else {
+            return true;
+        }
+    }
+
+    template <size_t I>
+    void submit_from(sycl::queue& queue, frame_view const& view,
+                     std::array<bool, N> const& dirty,
+                     std::array<resource_state, 32>& resources,
+                     std::array<std::optional<node_events>, N>& submitted)
+    {
+        if constexpr (I < N) {
+            static constexpr size_t E = group_end[I];
+            if (dirty[I]) {
+                std::vector<sycl::event> deps;
+                uint32_t touched = 0;
+                for (size_t i = I; i < E; ++i) {
+                    touched |= reads[i] | writes[i];
+                }
+                for (size_t r = 0; r < resources.size(); ++r) {
+                    if (touched & (1u << r) && resources[r].writer) {
+                        deps.push_back(*resources[r].writer);
+                    }
+                }
+                for (size_t i = I; i < E; ++i) {
+                    for (size_t r = 0; r < resources.size(); ++r) {
+                        if (writes[i] & (1u << r)) {
+                            deps.insert(deps.end(), resources[r].readers.begin(), resources[r].readers.end());
+                        }
+                    }
+                }
+                if (auto events = this->submit_group<I>(queue, view, deps,
+                                                        std::make_index_sequence<E - I>()))
+                {
+                    for (size_t i = I; i < E; ++i) {
+                        for (size_t r = 0; r < resources.size(); ++r) {
+                            if (writes[i] & (1u << r)) {
+                                resources[r].writer = events->last;
+                                resources[r].readers.clear();
+                            }
+                            else if (reads[i] & (1u << r)) {
+                                resources[r].readers.push_back(events->last);
+                            }
+                        }
+                    }
+                    submitted[I] = std::move(events);
+                }
+            }
+            this->submit_from<E>(queue, view, dirty, resources, submitted);
+        }
+    }
+
+    template <size_t I, size_t... J>
+    std::optional<node_events> submit_group(sycl::queue& queue, frame_view const& view,
+                                            std::vector<sycl::event> const& deps,
+                                            std::index_sequence<J...>)
+    {
+        if constexpr (elementwise[I]) {
+            uint32_t mask = ((uint32_t(enabled(std::get<I + J>(this->nodes_))) << J) | ... | 0);
+            if (mask == 0) {
+                return std::nullopt;
+            }
+            return this->submit_fused<I, sizeof... (J)>(queue, view, deps, mask,
+                                                        std::make_integer_sequence<uint32_t, (1u << sizeof... (J))>());
+        }
+        else {
+            auto& node = std::get<I>(this->nodes_);
+            if (!enabled(node)) {
+                return std::nullopt;
+            }
+            return node.submit(queue, view, deps);
+        }
+    }
+
+    // Disabled members are left out of the kernel rather than tested for every
+    // pixel: each subset of the M nodes of a group is its own instantiation.
+    template <size_t I, size_t M, uint32_t... Mask>
+    node_events submit_fused(sycl::queue& queue, frame_view const& view,
+                             std::vector<sycl::event> const& deps,
+                             uint32_t mask, std::integer_sequence<uint32_t, Mask...>)
+    {
+        std::optional<node_events> events;
+        ((mask == Mask && (events = this->launch_fused<I, Mask>(queue, view, deps,
+                                                                 std::make_index_sequence<M>()), true)) || ...);
+        return *events;
+    }
+
+    template <size_t I, uint32_t Mask, size_t... J>
+    node_events launch_fused(sycl::queue& queue, frame_view const& view,
+                             std::vector<sycl::event> const& deps,
+                             std::index_sequence<J...>)
+    {
+        auto fused = std::tuple_cat(this->fused_member<I + J, (Mask >> J) & 1>()...);
+        auto e = queue.parallel_for(sycl::range<1>{view.size()}, deps, [=](sycl::id<1> idx) {
+            std::apply([&](auto const&... node) { (node(view, idx[0]), ...); }, fused);
+        });
+        return node_events{e, e};
+    }
+
+    template <size_t K, bool On>
+    auto fused_member() const {
+        if constexpr (On) {
+            return std::tuple(std::get<K>(this->nodes_));
+        }
+        else {
+            return std::tuple<>();
+        }
+    }
+
+    void collect_timings(sycl::queue& queue,
+                         std::array<std::optional<node_events>, N> const& submitted)
+    {
+        using namespace sycl::info;
+        bool profiling = queue.has_property<sycl::property::queue::enable_profiling>();
+        for (size_t i = 0; i < N; i = group_end[i]) {
+            auto& t = this->timings_[i];
+            if (!submitted[i]) {
+                ++t.skips;
+                continue;
+            }
+            ++t.runs;
+            if (profiling) {
+                auto t0 = submitted[i]->first.template get_profiling_info<event_profiling::command_start>();
+                auto t1 = submitted[i]->last.template get_profiling_info<event_profiling::command_end>();
+                t.last_ms = (t1 - t0) * 1e-6;
+                t.total_ms += t.last_ms;
+            }
+        }
+    }
+
+private:
+    std::tuple<Nodes...> nodes_;
+    std::tuple<std::optional<decltype (std::declval<Nodes const&>().key())>...> keys_;
+    std::array<node_timing, N> timings_;
+    std::array<bool, N> was_active_{};
+};
+
+} // end of namespace render_graph_executor
+
+#endif/*INCLUDE_RENDER_GRAPH_HPP_F705AB5E_A1FF_426B_B051_92E0AEBF66B7*/
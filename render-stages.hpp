@@ -0,0 +1,242 @@
+#ifndef INCLUDE_RENDER_STAGES_HPP_C8915405_0773_485C_BC17_E2D8EF83BFEB
+#define INCLUDE_RENDER_STAGES_HPP_C8915405_0773_485C_BC17_E2D8EF83BFEB
+
+#include <algorithm>
+#include <complex>
+#include <numbers>
+#include <vector>
+#include <tuple>
+#include <string_view>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#include <CL/sycl.hpp>
+
+#include "versor.hpp"
+#include "point-cloud.hpp"
+#include "frame-view.hpp"
+#include "density.hpp"
+#include "spiral-math.hpp"
+#include "resource-accounting.hpp"
+
+inline namespace render_stages
+{
+
+struct clear_stage {
+    static constexpr std::string_view name = "clear";
+    static constexpr bool elementwise = true;
+    static constexpr uint32_t reads  = 0;
+    static constexpr uint32_t writes = resource::framebuffer;
+
+    color background;
+
+    auto key() const noexcept { return std::bit_cast<uint32_t>(this->background); }
+    void operator()(frame_view const& view, size_t i) const noexcept {
+        view.pixels[i] = this->background;
+    }
+};
+
+struct spiral_stage {
+    static constexpr std::string_view name = "spiral";
+    static constexpr bool elementwise = false;
+    static constexpr uint32_t reads  = 0;
+    static constexpr uint32_t writes = resource::framebuffer | resource::density;
+
+    bool active;
+    std::complex<float> pt;
+    size_t count;
+    float scale = 1.0f;
+    scatter_mode mode = scatter_mode::last_writer;
+    density_accumulator* accumulator = nullptr;
+    spiral_math math = spiral_math::precise;
+
+    bool enabled() const noexcept { return this->active; }
+    auto key() const noexcept {
+        // Nothing of an inactive spiral shows, whatever the pointer does.
+        if (!this->active) {
+            return std::tuple(false, 0.0f, 0.0f, size_t(0), 0.0f,
+                              scatter_mode::last_writer, spiral_math::precise);
+        }
+        return std::tuple(this->active, this->pt.real(), this->pt.imag(),
+                          this->count, this->scale, this->mode, this->math);
+    }
+    node_events submit(sycl::queue& queue, frame_view const& view,
+                       std::vector<sycl::event> const& deps) const
+    {
+        return with_spiral_math(this->math, [&](auto math) {
+            return this->submit_with<decltype (math)::value>(queue, view, deps);
+        });
+    }
+
+private:
+    template <spiral_math Math>
+    node_events submit_with(sycl::queue& queue, frame_view const& view,
+                            std::vector<sycl::event> const& deps) const
+    {
+        auto position = spiral_position<Math>{this->pt, this->scale};
+        if (this->mode != scatter_mode::last_writer) {
+            return this->accumulator->accumulate(this->mode, view, this->count, position, deps);
+        }
+        auto resolution = this->count;
+        auto e = for_each_spiral_point(queue, this->count, position, deps, [=](size_t idx, std::complex<float> c) {
+            view.plot(c.real(), c.imag(), color(0xC0, 0xC0 - 0xC0*idx/resolution));
+        });
+        return {e, e};
+    }
+};
+
+// Maps point cloud coordinates into the frame, preserving the aspect ratio.
+struct fit_transform {
+    float scale;
+    float x0, y0;
+
+    fit_transform(point_cloud_header const& header, frame_view const& view) noexcept {
+        auto cx = static_cast<float>(view.cx);
+        auto cy = static_cast<float>(view.cy);
+        auto w = header.max_x - header.min_x;
+        auto h = header.max_y - header.min_y;
+        // A degenerate axis takes the scale of the other one; a single
+        // distinct point is drawn unscaled, in the centre.
+        if (0 < w && 0 < h) {
+            this->scale = std::min(cx / w, cy / h);
+        }
+        else if (0 < w) {
+            this->scale = cx / w;
+        }
+        else if (0 < h) {
+            this->scale = cy / h;
+        }
+        else {
+            this->scale = 1;
+        }
+        this->x0 = (cx - w * this->scale) / 2 - header.min_x * this->scale;
+        this->y0 = (cy - h * this->scale) / 2 - header.min_y * this->scale;
+    }
+    float x(float v) const noexcept { return this->x0 + v * this->scale; }
+    float y(float v) const noexcept { return this->y0 + v * this->scale; }
+};
+
+// Streams a mapped point cloud to the device through a fixed number of chunk
+// slots, so that the upload of one chunk overlaps the scatter of the previous
+// one and the device footprint stays at depth * chunk_size records.
+class point_stream {
+    struct slot {
+        point_record* points;
+        sycl::event done; // the last scatter that read this slot
+    };
+
+public:
+    point_stream(sycl::queue& queue, size_t chunk_size, size_t depth = 2)
+        : queue_(queue), chunk_size_(chunk_size)
+        {
+            this->allocate(depth);
+        }
+    point_stream(point_stream const&) = delete;
+    point_stream& operator=(point_stream const&) = delete;
+    ~point_stream() noexcept {
+        this->release();
+    }
+
+    [[nodiscard]] size_t depth() const noexcept { return this->slots_.size(); }
+
+    // Changes the number of slots; waits for the scatters in flight.
+    void resize(size_t depth) {
+        if (depth != this->depth()) {
+            this->release();
+            this->allocate(depth);
+        }
+    }
+
+    // The scatters are chained so that later records land on top, as with a
+    // single kernel; only the uploads run ahead.
+    node_events scatter(frame_view const& view, mapped_point_cloud const& cloud,
+                        std::vector<sycl::event> deps)
+    {
+        auto fit = fit_transform(cloud.header(), view);
+        node_events events;
+        size_t k = 0;
+        for (auto chunk : cloud.chunks(this->chunk_size_)) {
+            auto& s = this->slots_[k++ % this->slots_.size()];
+            auto uploaded = this->queue_.memcpy(s.points, chunk.data(), chunk.size_bytes(), s.done);
+            if (k == 1) {
+                events.first = uploaded;
+            }
+            deps.push_back(uploaded);
+            auto points = s.points;
+            s.done = this->queue_.parallel_for(sycl::range<1>{chunk.size()}, deps, [=](sycl::id<1> idx) {
+                auto p = points[idx];
+                view.plot(fit.x(p.x), fit.y(p.y), std::bit_cast<color>(p.argb));
+            });
+            deps = {s.done};
+            events.last = s.done;
+        }
+        if (k == 0) {
+            events.first = events.last = this->queue_.single_task(deps, [] { });
+        }
+        return events;
+    }
+
+private:
+    void allocate(size_t depth) {
+        this->slots_.resize(depth);
+        for (auto& s : this->slots_) {
+            s.points = sycl::malloc_device<point_record>(this->chunk_size_, this->queue_);
+        }
+        track_acquire(account::device, depth * this->chunk_size_ * sizeof (point_record), depth);
+    }
+    void release() noexcept {
+        this->queue_.wait();
+        for (auto& s : this->slots_) {
+            sycl::free(s.points, this->queue_);
+        }
+        track_release(account::device, this->depth() * this->chunk_size_ * sizeof (point_record),
+                      this->depth());
+        this->slots_.clear();
+    }
+
+private:
+    sycl::queue& queue_;
+    size_t chunk_size_;
+    std::vector<slot> slots_;
+};
+
+struct point_cloud_stage {
+    static constexpr std::string_view name = "points";
+    static constexpr bool elementwise = false;
+    static constexpr uint32_t reads  = 0;
+    static constexpr uint32_t writes = resource::framebuffer;
+
+    point_stream* stream;
+    mapped_point_cloud const* cloud;
+
+    bool enabled() const noexcept { return this->cloud != nullptr; }
+    auto key() const noexcept { return this->cloud; }
+    node_events submit(sycl::queue&, frame_view const& view,
+                       std::vector<sycl::event> const& deps) const
+    {
+        return this->stream->scatter(view, *this->cloud, deps);
+    }
+};
+
+// Copies the finished frame into the shm buffer.
+struct present_stage {
+    static constexpr std::string_view name = "present";
+    static constexpr bool elementwise = false;
+    static constexpr uint32_t reads  = resource::framebuffer;
+    static constexpr uint32_t writes = resource::presented;
+
+    color* target;
+
+    auto key() const noexcept { return this->target; }
+    node_events submit(sycl::queue& queue, frame_view const& view,
+                       std::vector<sycl::event> const& deps) const
+    {
+        auto e = queue.memcpy(this->target, view.pixels, view.size() * sizeof (color), deps);
+        return {e, e};
+    }
+};
+
+} // end of namespace render_stages
+
+#endif/*INCLUDE_RENDER_STAGES_HPP_C8915405_0773_485C_BC17_E2D8EF83BFEB*/
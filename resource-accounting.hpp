@@ -0,0 +1,142 @@
+#ifndef INCLUDE_RESOURCE_ACCOUNTING_HPP_8A41D3C2_6E0F_4B8B_A2D9_5C7E13F0B264
+#define INCLUDE_RESOURCE_ACCOUNTING_HPP_8A41D3C2_6E0F_4B8B_A2D9_5C7E13F0B264
+
+#include <iostream>
+#include <iomanip>
+#include <array>
+#include <atomic>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
+
+inline namespace resource_accounting
+{
+
+enum class account : size_t {
+    shm,              // wl_shm pools handed to the compositor
+    device,           // USM device allocations
+    host_staging,     // host copies waiting to be consumed
+    mapped_files,     // memory-mapped input and output files
+    coroutine_frames, // generator frames, pooled or not
+    proxies,          // Wayland proxies owned through attach_unique
+};
+
+inline constexpr size_t account_count = 6;
+inline constexpr std::string_view account_names[account_count] = {
+    "shm", "device", "host staging", "mapped files", "coroutine frames", "proxies",
+};
+
+struct account_stats {
+    int64_t live_bytes;
+    int64_t live_count;
+    int64_t peak_bytes;
+    int64_t peak_count;
+    int64_t total_count; // acquisitions since start
+};
+
+// Process-wide counters, one cache line per account.  Updates are relaxed
+// atomics, so that they can sit on allocation paths.
+class resource_ledger {
+    struct alignas (64) counters {
+        std::atomic<int64_t> live_bytes = 0;
+        std::atomic<int64_t> live_count = 0;
+        std::atomic<int64_t> peak_bytes = 0;
+        std::atomic<int64_t> peak_count = 0;
+        std::atomic<int64_t> total_count = 0;
+    };
+
+public:
+    [[nodiscard]] static resource_ledger& instance() noexcept {
+        static resource_ledger ledger;
+        return ledger;
+    }
+
+    void acquire(account a, size_t bytes, size_t count = 1) noexcept {
+        auto& c = this->counters_[static_cast<size_t>(a)];
+        auto b = static_cast<int64_t>(bytes);
+        auto n = static_cast<int64_t>(count);
+        raise(c.peak_bytes, c.live_bytes.fetch_add(b, std::memory_order_relaxed) + b);
+        raise(c.peak_count, c.live_count.fetch_add(n, std::memory_order_relaxed) + n);
+        c.total_count.fetch_add(n, std::memory_order_relaxed);
+    }
+    void release(account a, size_t bytes, size_t count = 1) noexcept {
+        auto& c = this->counters_[static_cast<size_t>(a)];
+        c.live_bytes.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+        c.live_count.fetch_sub(static_cast<int64_t>(count), std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] account_stats stats(account a) const noexcept {
+        auto& c = this->counters_[static_cast<size_t>(a)];
+        return {
+            c.live_bytes.load(std::memory_order_relaxed),
+            c.live_count.load(std::memory_order_relaxed),
+            c.peak_bytes.load(std::memory_order_relaxed),
+            c.peak_count.load(std::memory_order_relaxed),
+            c.total_count.load(std::memory_order_relaxed),
+        };
+    }
+
+    void report(std::ostream& output) const {
+        for (size_t i = 0; i < account_count; ++i) {
+            auto s = this->stats(static_cast<account>(i));
+            output << std::setw(24) << std::left << account_names[i] << std::right
+                   << " live: "  << std::setw(12) << s.live_bytes << " B"
+                   << " / "      << std::setw(6)  << s.live_count
+                   << " peak: "  << std::setw(12) << s.peak_bytes << " B"
+                   << " / "      << std::setw(6)  << s.peak_count
+                   << " total: " << std::setw(8)  << s.total_count
+                   << std::endl;
+        }
+    }
+
+private:
+    resource_ledger() noexcept = default;
+
+    static void raise(std::atomic<int64_t>& peak, int64_t value) noexcept {
+        auto current = peak.load(std::memory_order_relaxed);
+        while (current < value && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+private:
+    std::array<counters, account_count> counters_;
+};
+
+inline void track_acquire(account a, size_t bytes, size_t count = 1) noexcept {
+    resource_ledger::instance().acquire(a, bytes, count);
+}
+inline void track_release(account a, size_t bytes, size_t count = 1) noexcept {
+    resource_ledger::instance().release(a, bytes, count);
+}
+
+// A coroutine frame allocator accounting every frame under coroutine_frames,
+// which leaves the allocation itself to Base; for instance
+// std::generator<T, accounted_frames<std::frame_pool<>>>.
+template <class Base>
+struct accounted_frames {
+    using value_type = typename Base::value_type;
+
+    [[nodiscard]] value_type* allocate(size_t size) {
+        auto ptr = Base().allocate(size);
+        track_acquire(account::coroutine_frames, size);
+        return ptr;
+    }
+    void deallocate(value_type* ptr, size_t size) noexcept {
+        track_release(account::coroutine_frames, size);
+        Base().deallocate(ptr, size);
+    }
+};
+
+// Counts the proxies of attach_unique; see proxy_observer.
+inline void track_proxy(int delta) noexcept {
+    if (0 < delta) {
+        track_acquire(account::proxies, 0);
+    }
+    else {
+        track_release(account::proxies, 0);
+    }
+}
+
+} // end of namespace resource_accounting
+
+#endif/*INCLUDE_RESOURCE_ACCOUNTING_HPP_8A41D3C2_6E0F_4B8B_A2D9_5C7E13F0B264*/
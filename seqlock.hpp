@@ -0,0 +1,69 @@
+#ifndef INCLUDE_SEQLOCK_HPP_F79B54AF_8EFF_4AED_AFE7_3A2F4EE24A35
+#define INCLUDE_SEQLOCK_HPP_F79B54AF_8EFF_4AED_AFE7_3A2F4EE24A35
+
+#include <atomic>
+#include <type_traits>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+inline namespace lockfree
+{
+
+// A single-writer snapshot of a trivially copyable value.  store() never
+// waits; load() retries while a store is in progress.  The value is kept in
+// relaxed atomic words so that racing reads are well defined.
+template <class T>
+class seqlock {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_default_constructible_v<T>);
+    static constexpr size_t words = (sizeof (T) + sizeof (uint64_t) - 1) / sizeof (uint64_t);
+
+public:
+    seqlock() noexcept { this->store(T{}); }
+    explicit seqlock(T const& value) noexcept { this->store(value); }
+
+    void store(T const& value) noexcept {
+        uint64_t buffer[words] = {};
+        std::memcpy(buffer, &value, sizeof (T));
+        auto seq = this->seq_.load(std::memory_order_relaxed);
+        this->seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < words; ++i) {
+            this->data_[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        this->seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    [[nodiscard]] T load() const noexcept {
+        uint64_t buffer[words];
+        for (;;) {
+            auto seq = this->seq_.load(std::memory_order_acquire);
+            if (seq & 1) {
+                continue;
+            }
+            for (size_t i = 0; i < words; ++i) {
+                buffer[i] = this->data_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (this->seq_.load(std::memory_order_relaxed) == seq) {
+                break;
+            }
+        }
+        T value;
+        std::memcpy(&value, buffer, sizeof (T));
+        return value;
+    }
+
+    // Incremented by every store(); tells whether anything was published.
+    [[nodiscard]] uint64_t version() const noexcept {
+        return this->seq_.load(std::memory_order_acquire) / 2;
+    }
+
+private:
+    std::atomic<uint64_t> seq_ = 0;
+    std::atomic<uint64_t> data_[words];
+};
+
+} // end of namespace lockfree
+
+#endif/*INCLUDE_SEQLOCK_HPP_F79B54AF_8EFF_4AED_AFE7_3A2F4EE24A35*/
@@ -0,0 +1,233 @@
+#ifndef INCLUDE_SPIRAL_MATH_HPP_5B8E2F14_C9A3_4D07_B6E1_0F4A9C3D7E25
+#define INCLUDE_SPIRAL_MATH_HPP_5B8E2F14_C9A3_4D07_B6E1_0F4A9C3D7E25
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <complex>
+#include <limits>
+#include <numbers>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+
+#include <CL/sycl.hpp>
+
+#include "frame-view.hpp"
+#include "resource-accounting.hpp"
+
+inline namespace spiral_math_variants
+{
+
+// How the points of the golden-angle spiral are computed.
+enum class spiral_math {
+    precise,    // std::polar and std::sqrt in float
+    native,     // native sin/cos and rsqrt after an explicit range reduction
+    half,       // sin/cos in half precision after the range reduction
+    recurrence, // runs of points rotated by the golden angle, one sin/cos per run
+};
+
+inline constexpr size_t spiral_math_count = 4;
+inline constexpr std::string_view spiral_math_names[spiral_math_count] = {
+    "precise", "native", "half", "recurrence",
+};
+
+// Whether the variant evaluates the same when the points are accessed one at
+// a time through spiral_position, as the density accumulator does, as when
+// they are produced by for_each_spiral_point.
+[[nodiscard]] constexpr bool is_pointwise(spiral_math math) noexcept {
+    return math != spiral_math::recurrence;
+}
+
+// With `pointwise`, only the variants for which is_pointwise holds.
+[[nodiscard]] inline std::optional<spiral_math> parse_spiral_math(std::string_view name,
+                                                                  bool pointwise = false) noexcept
+{
+    for (size_t i = 0; i < spiral_math_count; ++i) {
+        if (name == spiral_math_names[i] && (!pointwise || is_pointwise(static_cast<spiral_math>(i)))) {
+            return static_cast<spiral_math>(i);
+        }
+    }
+    return std::nullopt;
+}
+
+// Calls f with the variant as a compile-time constant.
+template <class F>
+decltype (auto) with_spiral_math(spiral_math math, F&& f) {
+    using enum spiral_math;
+    switch (math) {
+    case native:     return f(std::integral_constant<spiral_math, native>());
+    case half:       return f(std::integral_constant<spiral_math, half>());
+    case recurrence: return f(std::integral_constant<spiral_math, recurrence>());
+    default:         return f(std::integral_constant<spiral_math, precise>());
+    }
+}
+
+// Reduces a float angle into [-pi, pi] without adding to its error: 2 pi is
+// split into a head exact in a few bits and a tail, and each is subtracted
+// with a single rounding.
+inline float reduce_angle(float a) noexcept {
+    static constexpr float inv_two_pi = 0.5 / std::numbers::pi;
+    static constexpr float head = 6.28125f;
+    static constexpr float tail = 2 * std::numbers::pi - 6.28125;
+    float k = std::rint(a * inv_two_pi);
+    return std::fma(-k, tail, std::fma(-k, head, a));
+}
+
+// The i-th point of the golden-angle spiral around pt.  Every variant starts
+// from the same float angle as the precise one, so that they differ only in
+// how sin, cos and sqrt are evaluated.  Accessed one point at a time, the
+// recurrence has nothing to recur on and evaluates like native.
+template <spiral_math Math = spiral_math::precise>
+struct spiral_position {
+    std::complex<float> pt;
+    float scale;
+
+    std::complex<float> operator()(size_t idx) const noexcept {
+        static constexpr float pi = std::numbers::pi_v<float>;
+        static constexpr float phi = std::numbers::phi_v<float>;
+        float i = (1 + idx);
+        if constexpr (Math == spiral_math::precise) {
+            return this->pt + std::polar<float>(this->scale * std::sqrt(i), i*2*pi/phi);
+        }
+        else if constexpr (Math == spiral_math::half) {
+            auto a = sycl::half(reduce_angle(i*2*pi/phi));
+            float r = this->scale * std::sqrt(i);
+            return this->pt + std::complex<float>(r * float(sycl::cos(a)), r * float(sycl::sin(a)));
+        }
+        else {
+            auto a = reduce_angle(i*2*pi/phi);
+            float r = this->scale * i * sycl::native::rsqrt(i);
+            return this->pt + std::complex<float>(r * sycl::native::cos(a), r * sycl::native::sin(a));
+        }
+    }
+};
+
+// Runs f(idx, position) for each of the `count` points of the spiral.
+template <spiral_math Math, class F>
+sycl::event for_each_spiral_point(sycl::queue& queue, size_t count,
+                                  spiral_position<Math> position,
+                                  std::vector<sycl::event> const& deps, F f)
+{
+    if constexpr (Math != spiral_math::recurrence) {
+        return queue.parallel_for(sycl::range<1>{count}, deps, [=](sycl::id<1> idx) {
+            f(idx[0], position(idx[0]));
+        });
+    }
+    else {
+        // Each work-item starts a run of points at the precise angle and then
+        // rotates by the golden angle; the drift stays within a run.
+        static constexpr size_t run = 32;
+        static constexpr float pi = std::numbers::pi_v<float>;
+        static constexpr float phi = std::numbers::phi_v<float>;
+        auto rotation = std::polar<float>(1, 2*pi/phi);
+        float wr = rotation.real();
+        float wi = rotation.imag();
+        return queue.parallel_for(sycl::range<1>{(count + run - 1) / run}, deps, [=](sycl::id<1> g) {
+            auto first = g[0] * run;
+            auto last = std::min(first + run, count);
+            float i = (1 + first);
+            auto z = std::polar<float>(1, i*2*pi/phi);
+            float zr = z.real();
+            float zi = z.imag();
+            for (auto idx = first; idx < last; ++idx, i += 1) {
+                float r = position.scale * std::sqrt(i);
+                f(idx, position.pt + std::complex<float>(r * zr, r * zi));
+                float next = zr * wr - zi * wi;
+                zi = zr * wi + zi * wr;
+                zr = next;
+            }
+        });
+    }
+}
+
+// Accuracy against the precise spiral, and speed, of one variant.
+struct spiral_math_trial {
+    spiral_math math;
+    size_t mismatches; // points landing on another pixel than the precise one
+    double seconds;    // best time to compute every point
+};
+
+// Tries every variant on `count` points of a cx x cy frame, keeping the best
+// of `repeats` launches.  The launches are timed on the device when the queue
+// profiles, since the host clock mostly measures the submission otherwise.
+[[nodiscard]] inline std::vector<spiral_math_trial> trial_spiral_math(sycl::queue& queue,
+                                                                      size_t cx, size_t cy,
+                                                                      size_t count,
+                                                                      std::complex<float> pt,
+                                                                      float scale,
+                                                                      size_t repeats = 10)
+{
+    auto view = frame_view{.cx = cx, .cy = cy};
+    auto bytes = 2 * count * sizeof (uint32_t);
+    auto keys = sycl::malloc_device<uint32_t>(2 * count, queue);
+    if (!keys) {
+        std::cerr << "Failed to allocate the spiral math trial..." << std::endl;
+        return {};
+    }
+    track_acquire(account::device, bytes);
+    bool profiling = queue.has_property<sycl::property::queue::enable_profiling>();
+    auto keys_of = [&](auto math, uint32_t* out) {
+        return for_each_spiral_point<decltype (math)::value>(queue, count, {pt, scale}, {}, [=](size_t idx, std::complex<float> c) {
+            out[idx] = view.index_of(c.real(), c.imag());
+        });
+    };
+    std::vector<uint32_t> expected(count);
+    std::vector<uint32_t> actual(count);
+    keys_of(std::integral_constant<spiral_math, spiral_math::precise>(), keys).wait();
+    queue.memcpy(expected.data(), keys, count * sizeof (uint32_t)).wait();
+    std::vector<spiral_math_trial> trials;
+    for (size_t m = 0; m < spiral_math_count; ++m) {
+        spiral_math_trial trial{static_cast<spiral_math>(m), 0, std::numeric_limits<double>::max()};
+        with_spiral_math(trial.math, [&](auto math) {
+            for (size_t repeat = 0; repeat < repeats; ++repeat) {
+                auto t0 = std::chrono::steady_clock::now();
+                auto e = keys_of(math, keys + count);
+                e.wait();
+                auto t1 = std::chrono::steady_clock::now();
+                auto seconds = std::chrono::duration<double>(t1 - t0).count();
+                if (profiling) {
+                    using namespace sycl::info;
+                    auto start = e.template get_profiling_info<event_profiling::command_start>();
+                    auto end = e.template get_profiling_info<event_profiling::command_end>();
+                    seconds = (end - start) * 1e-9;
+                }
+                trial.seconds = std::min(trial.seconds, seconds);
+            }
+        });
+        queue.memcpy(actual.data(), keys + count, count * sizeof (uint32_t)).wait();
+        for (size_t i = 0; i < count; ++i) {
+            trial.mismatches += (expected[i] != actual[i]);
+        }
+        trials.push_back(trial);
+    }
+    sycl::free(keys, queue);
+    track_release(account::device, bytes);
+    return trials;
+}
+
+// The fastest variant missing at most `budget` of the points (a fraction).
+// The trials run through for_each_spiral_point, so with `pointwise` only the
+// variants which evaluate the same one point at a time are candidates.
+[[nodiscard]] inline spiral_math select_spiral_math(std::vector<spiral_math_trial> const& trials,
+                                                    size_t count, double budget,
+                                                    bool pointwise = false) noexcept
+{
+    auto best = spiral_math_trial{spiral_math::precise, 0, std::numeric_limits<double>::max()};
+    for (auto& trial : trials) {
+        if (pointwise && !is_pointwise(trial.math)) {
+            continue;
+        }
+        if (trial.mismatches <= budget * count && trial.seconds < best.seconds) {
+            best = trial;
+        }
+    }
+    return best.math;
+}
+
+} // end of namespace spiral_math_variants
+
+#endif/*INCLUDE_SPIRAL_MATH_HPP_5B8E2F14_C9A3_4D07_B6E1_0F4A9C3D7E25*/
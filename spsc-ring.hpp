@@ -0,0 +1,54 @@
+#ifndef INCLUDE_SPSC_RING_HPP_D4D6109E_54B0_44B2_9E2C_AF18345E978D
+#define INCLUDE_SPSC_RING_HPP_D4D6109E_54B0_44B2_9E2C_AF18345E978D
+
+#include <atomic>
+#include <optional>
+#include <utility>
+#include <cstddef>
+
+inline namespace lockfree
+{
+
+inline constexpr size_t cache_line = 64;
+
+// A bounded, wait-free ring for exactly one producer and one consumer thread.
+// N must be a power of two.
+template <class T, size_t N>
+class spsc_ring {
+    static_assert(N != 0 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+    template <class U>
+    [[nodiscard]] bool try_push(U&& value) noexcept {
+        auto tail = this->tail_.load(std::memory_order_relaxed);
+        if (tail - this->head_.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        this->items_[tail & (N - 1)] = std::forward<U>(value);
+        this->tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+    [[nodiscard]] std::optional<T> try_pop() noexcept {
+        auto head = this->head_.load(std::memory_order_relaxed);
+        if (head == this->tail_.load(std::memory_order_acquire)) {
+            return std::nullopt;
+        }
+        std::optional<T> value(std::move(this->items_[head & (N - 1)]));
+        this->head_.store(head + 1, std::memory_order_release);
+        return value;
+    }
+    [[nodiscard]] bool empty() const noexcept {
+        return this->head_.load(std::memory_order_acquire)
+            == this->tail_.load(std::memory_order_acquire);
+    }
+    static constexpr size_t capacity() noexcept { return N; }
+
+private:
+    alignas (cache_line) std::atomic<size_t> head_ = 0; // owned by the consumer
+    alignas (cache_line) std::atomic<size_t> tail_ = 0; // owned by the producer
+    alignas (cache_line) T items_[N];
+};
+
+} // end of namespace lockfree
+
+#endif/*INCLUDE_SPSC_RING_HPP_D4D6109E_54B0_44B2_9E2C_AF18345E978D*/
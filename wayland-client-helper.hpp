@@ -41,9 +41,16 @@ decltype (auto) operator << (std::basic_ostream<Ch>& output, T const* ptr) {
                   << ']';
 }
 
+// When set, told of every proxy attach_unique takes (+1) or releases (-1).
+// Set it before the first proxy is attached.
+inline void (*proxy_observer)(int delta) noexcept = nullptr;
+
 template <wl_client_t T>
 [[nodiscard]] auto attach_unique(T* ptr) noexcept {
     static constexpr auto deleter = [](T* ptr) noexcept -> void {
+        if (proxy_observer) {
+            proxy_observer(-1);
+        }
         static constexpr auto interface_addr = std::addressof(wl_interface_ref<T>);
         if      constexpr (interface_addr == std::addressof(wl_display_interface)) {
             wl_display_disconnect(ptr);
@@ -61,6 +68,9 @@ template <wl_client_t T>
             wl_proxy_destroy(reinterpret_cast<wl_proxy*>(ptr));
         }
     };
+    if (ptr && proxy_observer) {
+        proxy_observer(+1);
+    }
     return std::unique_ptr<T, decltype (deleter)>(ptr, deleter);
 }
 
@@ -85,6 +95,9 @@ void register_global_callback(void* data,
                                                                       name,
                                                                       &interface_ref,
                                                                       version)));
+                if (global && proxy_observer) {
+                    proxy_observer(+1);
+                }
                 return ;
             }
         }
@@ -0,0 +1,157 @@
+#ifndef INCLUDE_WAYLAND_IO_THREAD_HPP_132B1ADC_2374_4E0C_A8DD_9AB728CBD57D
+#define INCLUDE_WAYLAND_IO_THREAD_HPP_132B1ADC_2374_4E0C_A8DD_9AB728CBD57D
+
+#include <iostream>
+#include <atomic>
+#include <complex>
+#include <optional>
+#include <thread>
+#include <cerrno>
+#include <cstdint>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#include <wayland-client.h>
+
+#include "spsc-ring.hpp"
+#include "seqlock.hpp"
+
+inline namespace wayland_io
+{
+
+// The latest state of the input devices and of the surface configuration.
+struct input_snapshot {
+    std::complex<float> pointer;
+    int32_t width;
+    int32_t height;
+};
+
+struct key_event {
+    uint32_t key;
+    uint32_t state;
+};
+
+// Publishes what the Wayland listeners receive to the render loop without
+// locks: continuous state through a seqlocked snapshot, discrete key events
+// through an SPSC queue.  The listeners are the only producer, whichever
+// thread dispatches them.
+class input_channel {
+public:
+    // Producer side.
+    template <class F>
+    void update(F&& f) noexcept {
+        f(this->latest_);
+        this->snapshot_.store(this->latest_);
+    }
+    bool push_key(key_event e) noexcept {
+        return this->keys_.try_push(e);
+    }
+
+    // Consumer side.
+    [[nodiscard]] input_snapshot snapshot() const noexcept {
+        return this->snapshot_.load();
+    }
+    [[nodiscard]] std::optional<key_event> pop_key() noexcept {
+        return this->keys_.try_pop();
+    }
+
+private:
+    input_snapshot latest_ = {};
+    seqlock<input_snapshot> snapshot_;
+    spsc_ring<key_event, 256> keys_;
+};
+
+// Owns reading and dispatching of a wl_display on a dedicated thread, using
+// the prepare_read/read_events protocol, so that a slow frame does not delay
+// pings and input.  The render loop keeps sending requests and waits for
+// dispatched events with wait_events().
+class display_thread {
+public:
+    explicit display_thread(wl_display* display)
+        : display_(display),
+          wake_fd_(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)),
+          thread_([this] { this->run(); })
+        {
+        }
+    display_thread(display_thread const&) = delete;
+    display_thread& operator=(display_thread const&) = delete;
+    ~display_thread() noexcept {
+        this->stopping_.store(true, std::memory_order_release);
+        uint64_t one = 1;
+        [[maybe_unused]] auto n = write(this->wake_fd_, &one, sizeof (one));
+        this->thread_.join();
+        close(this->wake_fd_);
+    }
+
+    // Blocks until events were dispatched since the last call.  Returns false
+    // once the connection has failed.
+    bool wait_events() noexcept {
+        this->epoch_.wait(this->seen_, std::memory_order_acquire);
+        this->seen_ = this->epoch_.load(std::memory_order_acquire);
+        return this->alive_.load(std::memory_order_acquire);
+    }
+
+private:
+    void run() noexcept {
+        auto d = this->display_;
+        while (!this->stopping_.load(std::memory_order_acquire)) {
+            while (wl_display_prepare_read(d) != 0) {
+                if (wl_display_dispatch_pending(d) < 0) {
+                    return this->fail("wl_display_dispatch_pending");
+                }
+            }
+            if (wl_display_flush(d) < 0 && errno != EAGAIN) {
+                wl_display_cancel_read(d);
+                return this->fail("wl_display_flush");
+            }
+            pollfd fds[] = {
+                {wl_display_get_fd(d), POLLIN, 0},
+                {this->wake_fd_,       POLLIN, 0},
+            };
+            if (poll(fds, 2, -1) < 0) {
+                wl_display_cancel_read(d);
+                if (errno == EINTR) {
+                    continue;
+                }
+                return this->fail("poll");
+            }
+            if (fds[0].revents & POLLIN) {
+                if (wl_display_read_events(d) < 0) {
+                    return this->fail("wl_display_read_events");
+                }
+            }
+            else {
+                wl_display_cancel_read(d);
+            }
+            auto n = wl_display_dispatch_pending(d);
+            if (n < 0) {
+                return this->fail("wl_display_dispatch_pending");
+            }
+            if (0 < n) {
+                this->epoch_.fetch_add(1, std::memory_order_release);
+                this->epoch_.notify_one();
+            }
+        }
+    }
+    void fail(char const* what) noexcept {
+        std::cerr << what << " failed on the display thread..." << std::endl;
+        this->alive_.store(false, std::memory_order_release);
+        this->epoch_.fetch_add(1, std::memory_order_release);
+        this->epoch_.notify_one();
+    }
+
+private:
+    wl_display* display_;
+    int wake_fd_;
+    std::atomic<bool> stopping_ = false;
+    std::atomic<bool> alive_ = true;
+    std::atomic<uint32_t> epoch_ = 0;
+    uint32_t seen_ = 0; // owned by the render loop
+    std::thread thread_;
+};
+
+} // end of namespace wayland_io
+
+#endif/*INCLUDE_WAYLAND_IO_THREAD_HPP_132B1ADC_2374_4E0C_A8DD_9AB728CBD57D*/